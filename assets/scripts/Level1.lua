@@ -0,0 +1,106 @@
+-- Level 1: the jungle tilemap with a few vehicles driving over it
+
+Level = {
+    assets = {
+        { id = "tank-image",    file = "./assets/images/tank-panther-right.png" },
+        { id = "truck-image",   file = "./assets/images/truck-ford-right.png" },
+        { id = "chopper-image", file = "./assets/images/chopper.png" },
+        { id = "radar-image",   file = "./assets/images/radar.png" },
+        { id = "tilemap",       file = "./assets/tilemaps/jungle.png" },
+    },
+
+    tilemap = {
+        map_file = "./assets/tilemaps/jungle.map",
+        texture_asset_id = "tilemap",
+        tile_size = 32,
+        scale = 2.0,
+        -- number of tiles in one row of the tilemap texture
+        tiles_per_row = 10,
+    },
+
+    entities = {
+        -- chopper, steered with WASD, the arrow keys or a controller
+        {
+            transform = { position = { x = 10, y = 100 }, scale = { x = 1, y = 1 }, rotation = 0 },
+            rigidbody = { velocity = { x = 0, y = 0 } },
+            sprite = { texture_asset_id = "chopper-image", width = 32, height = 32, z_index = 1 },
+            animation = { num_frames = 2, speed_rate = 15, is_loop = true },
+            script = { behavior = "player" },
+        },
+        -- radar, in the top right corner of the window
+        {
+            transform = { position = { x = window_width - 74, y = 10 }, scale = { x = 1, y = 1 }, rotation = 0 },
+            rigidbody = { velocity = { x = 0, y = 0 } },
+            sprite = { texture_asset_id = "radar-image", width = 64, height = 64, z_index = 2 },
+            animation = { num_frames = 8, speed_rate = 5, is_loop = true },
+        },
+        -- tank
+        {
+            transform = { position = { x = 10, y = 10 }, scale = { x = 1, y = 1 }, rotation = 0 },
+            rigidbody = { velocity = { x = 30, y = 0 } },
+            sprite = { texture_asset_id = "tank-image", width = 32, height = 32, z_index = 1 },
+            box_collider = { width = 32, height = 32 },
+            script = { behavior = "patrol" },
+        },
+        -- truck
+        {
+            transform = { position = { x = 10, y = 50 }, scale = { x = 1, y = 1 }, rotation = 0 },
+            rigidbody = { velocity = { x = 20, y = 0 } },
+            sprite = { texture_asset_id = "truck-image", width = 32, height = 32, z_index = 2 },
+            box_collider = { width = 32, height = 32 },
+            script = { behavior = "patrol" },
+        },
+    },
+}
+
+-- Reads the map file into flat position and source rectangle arrays, so every
+-- tile of the map is spawned with a single spawn_prefab() call
+local function load_tilemap(tilemap)
+    local positions = {}
+    local src_rects = {}
+    local size = tilemap.tile_size * tilemap.scale
+    local count = 0
+    local y = 0
+    for line in io.lines(tilemap.map_file) do
+        local x = 0
+        for word in string.gmatch(line, "%d+") do
+            local tile = tonumber(word)
+            positions[2 * count + 1] = x * size
+            positions[2 * count + 2] = y * size
+            src_rects[2 * count + 1] = (tile % tilemap.tiles_per_row) * tilemap.tile_size
+            src_rects[2 * count + 2] = (tile // tilemap.tiles_per_row) * tilemap.tile_size
+            count = count + 1
+            x = x + 1
+        end
+        y = y + 1
+    end
+    return { positions = positions, src_rects = src_rects }
+end
+
+load_script("./assets/scripts/behaviors/Patrol.lua")
+load_script("./assets/scripts/behaviors/Player.lua")
+
+for _, asset in ipairs(Level.assets) do
+    add_texture(asset.id, asset.file)
+end
+
+local tile = {
+    transform = { scale = { x = Level.tilemap.scale, y = Level.tilemap.scale } },
+    sprite = {
+        texture_asset_id = Level.tilemap.texture_asset_id,
+        width = Level.tilemap.tile_size,
+        height = Level.tilemap.tile_size,
+        z_index = 0,
+    },
+}
+local first_tile, tile_count = spawn_prefab(tile, load_tilemap(Level.tilemap))
+
+-- Editing the map file while the game runs swaps the tiles, the other entities are not touched
+watch_file(Level.tilemap.map_file, function()
+    -- Read the map before killing the old tiles, a broken map file keeps them
+    local instances = load_tilemap(Level.tilemap)
+    kill_entities(first_tile, tile_count)
+    first_tile, tile_count = spawn_prefab(tile, instances)
+end)
+
+spawn_entities(Level.entities)
@@ -0,0 +1,28 @@
+-- Level 2: script stress test. Thousands of scripted tanks that bounce around
+-- the window, the behavior creates a few short-lived tables per entity every
+-- tick on purpose so the Lua collector has work to do. Compare the frame time
+-- statistics of e.g.
+--   ./gameengine --level 2 --lua-gc auto
+--   ./gameengine --level 2 --lua-gc incremental
+
+local count = 10000
+
+add_texture("tank-image", "./assets/images/tank-panther-right.png")
+
+load_script("./assets/scripts/behaviors/Bounce.lua")
+
+local positions = {}
+local velocities = {}
+for i = 0, count - 1 do
+    positions[2 * i + 1] = math.random() * (window_width - 32)
+    positions[2 * i + 2] = math.random() * (window_height - 32)
+    velocities[2 * i + 1] = math.random(-100, 100)
+    velocities[2 * i + 2] = math.random(-100, 100)
+end
+
+spawn_prefab({
+    transform = { scale = { x = 1, y = 1 } },
+    rigidbody = {},
+    sprite = { texture_asset_id = "tank-image", width = 32, height = 32, z_index = 1 },
+    script = { behavior = "bounce" },
+}, { positions = positions, velocities = velocities })
@@ -0,0 +1,24 @@
+-- Bounces off the window borders. Creates a few short-lived tables per entity
+-- every tick on purpose so the Lua collector has work to do
+
+local function vector(x, y)
+    return { x = x, y = y }
+end
+
+register_behavior("bounce", {
+    update = function(batch, dt)
+        local x, y, vx, vy = batch.x, batch.y, batch.vx, batch.vy
+        for i = 1, batch.count do
+            local position = vector(x[i], y[i])
+            local velocity = vector(vx[i], vy[i])
+            if position.x < 0 or position.x > window_width - 32 then
+                velocity = vector(-velocity.x, velocity.y)
+            end
+            if position.y < 0 or position.y > window_height - 32 then
+                velocity = vector(velocity.x, -velocity.y)
+            end
+            vx[i] = velocity.x
+            vy[i] = velocity.y
+        end
+    end,
+})
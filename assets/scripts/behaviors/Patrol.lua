@@ -0,0 +1,45 @@
+-- Vehicles drive back and forth, the direction flips every few seconds and
+-- whenever a vehicle runs into something.
+-- Loaded with load_script(), saving the file while the game runs reloads it
+
+local patrol_direction = 1
+
+-- Entity id -> true for vehicles driving against the patrol direction
+local turned = {}
+-- Entity id -> tick of its last collision, collisions are reported every tick
+-- while the boxes overlap and only the first tick of one turns a vehicle
+local last_contact = {}
+local tick = 0
+
+start_coroutine(function()
+    while true do
+        wait(4)
+        patrol_direction = -patrol_direction
+    end
+end)
+
+local function contact(id)
+    if last_contact[id] ~= tick - 1 and last_contact[id] ~= tick then
+        turned[id] = not turned[id]
+    end
+    last_contact[id] = tick
+end
+
+on_collision(function(batch)
+    for i = 1, batch.count do
+        contact(batch.first[i])
+        contact(batch.second[i])
+    end
+end)
+
+register_behavior("patrol", {
+    update = function(batch, dt)
+        tick = tick + 1
+        local ids = batch.ids
+        local vx = batch.vx
+        for i = 1, batch.count do
+            local direction = turned[ids[i]] and -patrol_direction or patrol_direction
+            vx[i] = math.abs(vx[i]) * direction
+        end
+    end,
+})
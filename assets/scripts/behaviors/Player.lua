@@ -0,0 +1,24 @@
+-- The player's chopper flies where the move actions point.
+-- Loaded with load_script(), saving the file while the game runs reloads it
+
+local SPEED = 100
+
+-- Looked up once, the queries in update() are bit tests
+local MOVE_UP = find_action("move_up")
+local MOVE_DOWN = find_action("move_down")
+local MOVE_LEFT = find_action("move_left")
+local MOVE_RIGHT = find_action("move_right")
+
+register_behavior("player", {
+    update = function(batch, dt)
+        local vx, vy = 0, 0
+        if action_down(MOVE_UP) then vy = vy - SPEED end
+        if action_down(MOVE_DOWN) then vy = vy + SPEED end
+        if action_down(MOVE_LEFT) then vx = vx - SPEED end
+        if action_down(MOVE_RIGHT) then vx = vx + SPEED end
+        for i = 1, batch.count do
+            batch.vx[i] = vx
+            batch.vy[i] = vy
+        end
+    end,
+})
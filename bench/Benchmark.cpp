@@ -0,0 +1,87 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+// Every benchmark is repeated at least this many times and until this much time was spent
+const size_t BENCHMARK_MIN_RUNS = 3;
+const size_t BENCHMARK_MAX_RUNS = 50;
+const double BENCHMARK_MIN_SECONDS = 0.5;
+
+void BenchmarkRunner::Add(const std::string &name, const std::vector<size_t> &sizes, BenchmarkFunction function)
+{
+    benchmarks.push_back({name, function, sizes});
+}
+
+void BenchmarkRunner::Run(const std::string &filter, size_t maxEntities)
+{
+    std::printf("%-32s %10s %6s %14s %14s\n", "benchmark", "entities", "runs", "best ns/op", "median ns/op");
+    for (const auto &benchmark : benchmarks)
+    {
+        if (benchmark.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+        for (auto entities : benchmark.sizes)
+        {
+            if (entities > maxEntities)
+            {
+                continue;
+            }
+
+            std::vector<double> runs;
+            size_t operations = 0;
+            const auto start = std::chrono::steady_clock::now();
+            while (runs.size() < BENCHMARK_MAX_RUNS &&
+                   (runs.size() < BENCHMARK_MIN_RUNS ||
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() <
+                        BENCHMARK_MIN_SECONDS))
+            {
+                BenchmarkTimer timer;
+                operations = benchmark.function(entities, timer);
+                runs.push_back(timer.GetNanoseconds());
+            }
+            std::sort(runs.begin(), runs.end());
+
+            BenchmarkResult result;
+            result.name = benchmark.name;
+            result.entities = entities;
+            result.runs = runs.size();
+            result.operations = operations;
+            result.bestNanoseconds = runs.front();
+            result.medianNanoseconds = runs[runs.size() / 2];
+            results.push_back(result);
+
+            const auto perOperation = std::max<size_t>(operations, 1);
+            std::printf("%-32s %10zu %6zu %14.2f %14.2f\n", result.name.c_str(), entities, result.runs,
+                        result.bestNanoseconds / perOperation, result.medianNanoseconds / perOperation);
+            std::fflush(stdout);
+        }
+    }
+}
+
+bool BenchmarkRunner::WriteJson(const std::string &path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(2);
+    file << "{\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const auto &result = results[i];
+        const auto perOperation = static_cast<double>(std::max<size_t>(result.operations, 1));
+        file << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"entities\": " << result.entities
+             << ", \"runs\": " << result.runs << ", \"operations\": " << result.operations
+             << ", \"best_ns\": " << result.bestNanoseconds << ", \"median_ns\": " << result.medianNanoseconds
+             << ", \"best_ns_per_op\": " << result.bestNanoseconds / perOperation
+             << ", \"median_ns_per_op\": " << result.medianNanoseconds / perOperation << "}";
+    }
+    file << "\n  ]\n}\n";
+    return true;
+}
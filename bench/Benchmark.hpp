@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////
+// Benchmark
+//////////////////////////////////////////////////////////////////////////////////
+// A benchmark runs one operation on a given number of entities. It does its
+// own (untimed) setup and measures only the interesting part with a
+// BenchmarkTimer, the runner repeats it and keeps the fastest run
+//////////////////////////////////////////////////////////////////////////////////
+class BenchmarkTimer
+{
+  private:
+    std::chrono::steady_clock::time_point start;
+    double elapsed = 0.0;
+
+  public:
+    void Start() { start = std::chrono::steady_clock::now(); }
+    void Stop()
+    {
+        elapsed += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    double GetNanoseconds() const { return elapsed; }
+};
+
+// Receives the number of entities, returns how many operations were timed
+using BenchmarkFunction = std::function<size_t(size_t entities, BenchmarkTimer &timer)>;
+
+struct Benchmark
+{
+    std::string name;
+    BenchmarkFunction function;
+    // Entity counts the benchmark is run with
+    std::vector<size_t> sizes;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    size_t entities;
+    size_t runs;
+    size_t operations;
+    double bestNanoseconds;
+    double medianNanoseconds;
+};
+
+class BenchmarkRunner
+{
+  private:
+    std::vector<Benchmark> benchmarks;
+    std::vector<BenchmarkResult> results;
+
+  public:
+    void Add(const std::string &name, const std::vector<size_t> &sizes, BenchmarkFunction function);
+
+    // Runs every benchmark whose name contains filter, skipping sizes above maxEntities
+    void Run(const std::string &filter, size_t maxEntities);
+
+    bool WriteJson(const std::string &path) const;
+};
+
+// Entity counts used by most benchmarks
+const std::vector<size_t> BENCHMARK_SIZES = {1000, 10000, 100000, 1000000};
+
+// Keeps the compiler from optimizing away a value
+template <typename T> void DoNotOptimize(const T &value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+// Benchmark registration, one function per benchmark source file
+void AddEcsBenchmarks(BenchmarkRunner &runner);
+void AddCollisionBenchmarks(BenchmarkRunner &runner);
+void AddSpatialBenchmarks(BenchmarkRunner &runner);
+void AddEventBenchmarks(BenchmarkRunner &runner);
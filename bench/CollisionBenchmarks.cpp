@@ -0,0 +1,121 @@
+#include "../src/Components/BoxColliderComponent.hpp"
+#include "../src/Components/RigidBodyComponent.hpp"
+#include "../src/Components/TranformComponent.hpp"
+#include "../src/ECS/ECS.hpp"
+#include "../src/EventBus/EventBus.hpp"
+#include "../src/Systems/CollisionSystem.hpp"
+#include "../src/Systems/MovementSystem.hpp"
+#include "Benchmark.hpp"
+
+#include <cmath>
+#include <memory>
+#include <random>
+
+// Simulated ticks per run, one second at 60 Hz
+const int COLLISION_BENCHMARK_TICKS = 60;
+const int COLLIDER_SIZE = 16;
+
+// Scatters moving boxes over a square world that grows with the count, so every
+// box overlaps about one other no matter how many there are
+static std::unique_ptr<Registry> CreateColliders(size_t count)
+{
+    auto registry = std::make_unique<Registry>();
+    registry->AddSystem<MovementSystem>();
+    registry->AddSystem<CollisionSystem>();
+    registry->Reserve(count);
+
+    const auto worldSize = static_cast<float>(std::sqrt(static_cast<double>(count)) * COLLIDER_SIZE * 2);
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> velocity(-50.0f, 50.0f);
+    Prefab<TransformComponent, RigidBodyComponent, BoxColliderComponent> prefab(
+        TransformComponent(), RigidBodyComponent(), BoxColliderComponent(COLLIDER_SIZE, COLLIDER_SIZE));
+    registry->CreateEntities(count, prefab,
+                             [&](size_t, TransformComponent &transform, RigidBodyComponent &rigidbody,
+                                 BoxColliderComponent &)
+                             {
+                                 transform.position = glm::vec2(position(random), position(random));
+                                 rigidbody.velocity = glm::vec2(velocity(random), velocity(random));
+                             });
+    registry->Update();
+    return registry;
+}
+
+// Counts the pairs it is sent, like a gameplay system reacting to collisions would look at them
+struct CollisionCounter
+{
+    size_t pairs = 0;
+
+    void OnCollisions(const CollisionEvent *, size_t count) { pairs += count; }
+};
+
+static size_t RunCollisionTicks(size_t count, BenchmarkTimer &timer, bool simd, bool events = false)
+{
+    auto registry = CreateColliders(count);
+    auto &movementSystem = registry->GetSystem<MovementSystem>();
+    auto &collisionSystem = registry->GetSystem<CollisionSystem>();
+    collisionSystem.SetSimd(simd);
+    EventBus eventBus;
+    CollisionCounter counter;
+    if (events)
+    {
+        eventBus.Subscribe<CollisionEvent, &CollisionCounter::OnCollisions>(&counter);
+    }
+
+    // The first update grows the grid arrays and the pair buffer, that's level loading and not measured
+    collisionSystem.Update(eventBus);
+    eventBus.Clear();
+
+    size_t pairs = 0;
+    for (int tick = 0; tick < COLLISION_BENCHMARK_TICKS; tick++)
+    {
+        movementSystem.Update(1.0 / 60.0);
+        timer.Start();
+        collisionSystem.Update(eventBus);
+        eventBus.Dispatch();
+        timer.Stop();
+        pairs += collisionSystem.GetCollisions().size();
+    }
+    DoNotOptimize(pairs);
+    DoNotOptimize(counter.pairs);
+    return count * COLLISION_BENCHMARK_TICKS;
+}
+
+void AddCollisionBenchmarks(BenchmarkRunner &runner)
+{
+    // Per collider and tick
+    runner.Add("CollisionSystem::Update (SSE)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer) { return RunCollisionTicks(count, timer, true); });
+
+    runner.Add("CollisionSystem::Update (scalar)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer) { return RunCollisionTicks(count, timer, false); });
+
+    // Plus a CollisionEvent per pair, dispatched to one subscriber
+    runner.Add("CollisionSystem::Update (events)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer) { return RunCollisionTicks(count, timer, true, true); });
+
+    // What the grid saves: every box against every other box, one tick
+    runner.Add("Collision brute force", {1000, 10000},
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   auto registry = CreateColliders(count);
+                   const auto &transforms = *registry->GetOrCreatePool<TransformComponent>();
+                   size_t pairs = 0;
+                   timer.Start();
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       const auto a = transforms.Get(static_cast<int>(i)).position;
+                       for (size_t j = i + 1; j < count; j++)
+                       {
+                           const auto b = transforms.Get(static_cast<int>(j)).position;
+                           if (std::abs(a.x - b.x) < COLLIDER_SIZE && std::abs(a.y - b.y) < COLLIDER_SIZE)
+                           {
+                               pairs++;
+                           }
+                       }
+                   }
+                   timer.Stop();
+                   DoNotOptimize(pairs);
+                   return count;
+               });
+}
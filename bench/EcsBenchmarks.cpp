@@ -0,0 +1,212 @@
+#include "../src/Components/RigidBodyComponent.hpp"
+#include "../src/Components/TranformComponent.hpp"
+#include "../src/ECS/ECS.hpp"
+#include "../src/Systems/MovementSystem.hpp"
+#include "Benchmark.hpp"
+
+#include <memory>
+#include <string>
+
+// Stands in for components such as SpriteComponent that own heap memory. The
+// name is longer than the small string buffer so every copy allocates
+struct NamedComponent
+{
+    std::string name;
+    int value;
+
+    NamedComponent(std::string name = "", int value = 0) : name(std::move(name)), value(value) {}
+};
+
+// Creates entities with a transform and a rigid body and hands them to the systems
+static std::unique_ptr<Registry> CreateMovingEntities(size_t count)
+{
+    auto registry = std::make_unique<Registry>();
+    registry->AddSystem<MovementSystem>();
+    for (size_t i = 0; i < count; i++)
+    {
+        Entity entity = registry->CreateEntity();
+        entity.AddComponent<TransformComponent>(glm::vec2(i, i), glm::vec2(1.0, 1.0), 0.0);
+        entity.AddComponent<RigidBodyComponent>(glm::vec2(10.0, 5.0));
+    }
+    registry->Update();
+    return registry;
+}
+
+void AddEcsBenchmarks(BenchmarkRunner &runner)
+{
+    runner.Add("CreateEntity", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   Registry registry;
+                   timer.Start();
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       DoNotOptimize(registry.CreateEntity());
+                   }
+                   timer.Stop();
+                   return count;
+               });
+
+    runner.Add("AddComponent", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   Registry registry;
+                   std::vector<Entity> entities;
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       entities.push_back(registry.CreateEntity());
+                   }
+                   timer.Start();
+                   for (auto entity : entities)
+                   {
+                       entity.AddComponent<TransformComponent>(glm::vec2(1.0, 2.0), glm::vec2(1.0, 1.0), 0.0);
+                   }
+                   timer.Stop();
+                   return count;
+               });
+
+    runner.Add("AddComponent (std::string)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   Registry registry;
+                   std::vector<Entity> entities;
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       entities.push_back(registry.CreateEntity());
+                   }
+                   timer.Start();
+                   for (auto entity : entities)
+                   {
+                       entity.AddComponent<NamedComponent>("a-name-too-long-for-sso", 1);
+                   }
+                   timer.Stop();
+                   return count;
+               });
+
+    // Same entities created one by one and in bulk from a prefab
+    runner.Add("CreateEntity + 2x AddComponent", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   Registry registry;
+                   registry.AddSystem<MovementSystem>();
+                   timer.Start();
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       Entity entity = registry.CreateEntity();
+                       entity.AddComponent<TransformComponent>(glm::vec2(i, i), glm::vec2(1.0, 1.0), 0.0);
+                       entity.AddComponent<RigidBodyComponent>(glm::vec2(10.0, 5.0));
+                   }
+                   registry.Update();
+                   timer.Stop();
+                   return count;
+               });
+
+    runner.Add("CreateEntity + 2x AddComponent (Reserve)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   Registry registry;
+                   registry.AddSystem<MovementSystem>();
+                   timer.Start();
+                   registry.Reserve(count);
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       Entity entity = registry.CreateEntity();
+                       entity.AddComponent<TransformComponent>(glm::vec2(i, i), glm::vec2(1.0, 1.0), 0.0);
+                       entity.AddComponent<RigidBodyComponent>(glm::vec2(10.0, 5.0));
+                   }
+                   registry.Update();
+                   timer.Stop();
+                   return count;
+               });
+
+    runner.Add("CreateEntities (prefab)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   Registry registry;
+                   registry.AddSystem<MovementSystem>();
+                   Prefab prefab(TransformComponent(glm::vec2(0.0, 0.0), glm::vec2(1.0, 1.0), 0.0),
+                                 RigidBodyComponent(glm::vec2(10.0, 5.0)));
+                   timer.Start();
+                   registry.CreateEntities(count, prefab,
+                                           [](size_t i, TransformComponent &transform, RigidBodyComponent &)
+                                           { transform.position = glm::vec2(i, i); });
+                   registry.Update();
+                   timer.Stop();
+                   return count;
+               });
+
+    runner.Add("GetComponent", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   auto registry = CreateMovingEntities(count);
+                   float sum = 0.0f;
+                   timer.Start();
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       Entity entity(static_cast<int>(i));
+                       sum += registry->GetComponent<TransformComponent>(entity).position.x;
+                   }
+                   timer.Stop();
+                   DoNotOptimize(sum);
+                   return count;
+               });
+
+    runner.Add("MovementSystem::Update", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   auto registry = CreateMovingEntities(count);
+                   auto &movementSystem = registry->GetSystem<MovementSystem>();
+                   timer.Start();
+                   movementSystem.Update(1.0 / 60.0);
+                   timer.Stop();
+                   return count;
+               });
+
+    runner.Add("Registry::Update (add)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   Registry registry;
+                   registry.AddSystem<MovementSystem>();
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       Entity entity = registry.CreateEntity();
+                       entity.AddComponent<TransformComponent>();
+                       entity.AddComponent<RigidBodyComponent>();
+                   }
+                   timer.Start();
+                   registry.Update();
+                   timer.Stop();
+                   return count;
+               });
+
+    runner.Add("CreateEntity + Registry::Update", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   Registry registry;
+                   registry.AddSystem<MovementSystem>();
+                   timer.Start();
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       registry.CreateEntity();
+                   }
+                   registry.Update();
+                   timer.Stop();
+                   return count;
+               });
+
+    runner.Add("KillEntity + Registry::Update", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   auto registry = CreateMovingEntities(count);
+                   timer.Start();
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       Entity entity(static_cast<int>(i));
+                       entity.registry = registry.get();
+                       entity.Kill();
+                   }
+                   registry->Update();
+                   timer.Stop();
+                   return count;
+               });
+}
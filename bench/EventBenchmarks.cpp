@@ -0,0 +1,165 @@
+#include "../src/EventBus/EventBus.hpp"
+#include "Benchmark.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Subscribers per event type, every event is delivered to all of them
+const int LISTENER_COUNT = 4;
+
+struct DamageEvent
+{
+    int target;
+    int source;
+    float amount;
+};
+
+struct DamageListener
+{
+    double total = 0.0;
+
+    void OnDamage(const DamageEvent &event) { total += event.amount; }
+    void OnDamageBatch(const DamageEvent *events, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            total += events[i].amount;
+        }
+    }
+};
+
+static double SumTotals(const std::vector<DamageListener> &listeners)
+{
+    double total = 0.0;
+    for (const auto &listener : listeners)
+    {
+        total += listener.total;
+    }
+    return total;
+}
+
+// The common alternative to compare against: every event is a heap object and
+// every listener a std::function
+struct NaiveEvent
+{
+    virtual ~NaiveEvent() = default;
+};
+
+struct NaiveDamageEvent : NaiveEvent
+{
+    DamageEvent damage;
+};
+
+void AddEventBenchmarks(BenchmarkRunner &runner)
+{
+    // Per event, emitting and dispatching to every listener. The bus is used
+    // twice and the second round is measured, the buffers have grown by then
+    runner.Add("EventBus deferred", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   EventBus eventBus;
+                   std::vector<DamageListener> listeners(LISTENER_COUNT);
+                   for (auto &listener : listeners)
+                   {
+                       eventBus.Subscribe<DamageEvent, &DamageListener::OnDamage>(&listener);
+                   }
+                   for (int round = 0; round < 2; round++)
+                   {
+                       if (round == 1)
+                       {
+                           timer.Start();
+                       }
+                       for (size_t i = 0; i < count; i++)
+                       {
+                           eventBus.Emit<DamageEvent>(static_cast<int>(i), 0, 1.0f);
+                       }
+                       eventBus.Dispatch();
+                   }
+                   timer.Stop();
+                   DoNotOptimize(SumTotals(listeners));
+                   return count;
+               });
+
+    runner.Add("EventBus deferred (batch handlers)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   EventBus eventBus;
+                   std::vector<DamageListener> listeners(LISTENER_COUNT);
+                   for (auto &listener : listeners)
+                   {
+                       eventBus.Subscribe<DamageEvent, &DamageListener::OnDamageBatch>(&listener);
+                   }
+                   for (int round = 0; round < 2; round++)
+                   {
+                       if (round == 1)
+                       {
+                           timer.Start();
+                       }
+                       for (size_t i = 0; i < count; i++)
+                       {
+                           eventBus.Emit<DamageEvent>(static_cast<int>(i), 0, 1.0f);
+                       }
+                       eventBus.Dispatch();
+                   }
+                   timer.Stop();
+                   DoNotOptimize(SumTotals(listeners));
+                   return count;
+               });
+
+    runner.Add("EventBus immediate", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   EventBus eventBus;
+                   std::vector<DamageListener> listeners(LISTENER_COUNT);
+                   for (auto &listener : listeners)
+                   {
+                       eventBus.Subscribe<DamageEvent, &DamageListener::OnDamage>(&listener);
+                   }
+                   timer.Start();
+                   for (size_t i = 0; i < count; i++)
+                   {
+                       eventBus.EmitNow(DamageEvent{static_cast<int>(i), 0, 1.0f});
+                   }
+                   timer.Stop();
+                   DoNotOptimize(SumTotals(listeners));
+                   return count;
+               });
+
+    runner.Add("std::function bus (heap events)", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   std::vector<DamageListener> listeners(LISTENER_COUNT);
+                   std::vector<std::function<void(const NaiveEvent &)>> handlers;
+                   for (auto &listener : listeners)
+                   {
+                       handlers.push_back([&listener](const NaiveEvent &event)
+                                          { listener.OnDamage(static_cast<const NaiveDamageEvent &>(event).damage); });
+                   }
+                   std::vector<std::unique_ptr<NaiveEvent>> queue;
+                   for (int round = 0; round < 2; round++)
+                   {
+                       if (round == 1)
+                       {
+                           timer.Start();
+                       }
+                       for (size_t i = 0; i < count; i++)
+                       {
+                           auto event = std::make_unique<NaiveDamageEvent>();
+                           event->damage = {static_cast<int>(i), 0, 1.0f};
+                           queue.push_back(std::move(event));
+                       }
+                       for (const auto &handler : handlers)
+                       {
+                           for (const auto &event : queue)
+                           {
+                               handler(*event);
+                           }
+                       }
+                       queue.clear();
+                   }
+                   timer.Stop();
+                   DoNotOptimize(SumTotals(listeners));
+                   return count;
+               });
+}
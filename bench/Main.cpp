@@ -0,0 +1,60 @@
+#include "../src/Logger/Logger.hpp"
+#include "Benchmark.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+static void PrintUsage(const char *program)
+{
+    std::fprintf(stderr, "Usage: %s [--filter TEXT] [--max-entities N] [--json FILE]\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    std::string jsonPath;
+    size_t maxEntities = std::numeric_limits<size_t>::max();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--max-entities") == 0 && i + 1 < argc)
+        {
+            maxEntities = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            jsonPath = argv[++i];
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Keep log output away from the measurements
+    Logger::Init();
+
+    BenchmarkRunner runner;
+    AddEcsBenchmarks(runner);
+    AddCollisionBenchmarks(runner);
+    AddSpatialBenchmarks(runner);
+    AddEventBenchmarks(runner);
+    runner.Run(filter, maxEntities);
+
+    Logger::Shutdown();
+
+    if (!jsonPath.empty() && !runner.WriteJson(jsonPath))
+    {
+        std::fprintf(stderr, "Could not write %s\n", jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
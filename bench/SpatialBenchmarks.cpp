@@ -0,0 +1,259 @@
+#include "../src/Spatial/AabbTree.hpp"
+#include "Benchmark.hpp"
+
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+// SpatialSystem needs the sprite component and with it SDL, so these benchmarks
+// drive the AabbTree directly with the same kind of boxes
+
+const int SPATIAL_BENCHMARK_TICKS = 60;
+const int QUERY_COUNT = 1000;
+const float BOX_SIZE = 16.0f;
+// About a screen, and the reach of a weapon
+const glm::vec2 QUERY_AREA = glm::vec2(800.0f, 600.0f);
+const float QUERY_RADIUS = 200.0f;
+const float RAY_LENGTH = 1000.0f;
+
+struct SpatialScene
+{
+    float worldSize;
+    std::vector<glm::vec2> positions;
+    std::vector<glm::vec2> velocities;
+
+    Aabb GetBox(size_t i) const { return {positions[i], positions[i] + glm::vec2(BOX_SIZE)}; }
+};
+
+// Boxes spread over a square world that grows with the count, the same density as the collision benchmarks
+static SpatialScene CreateScene(size_t count)
+{
+    SpatialScene scene;
+    scene.worldSize = static_cast<float>(std::sqrt(static_cast<double>(count)) * BOX_SIZE * 2);
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(0.0f, scene.worldSize);
+    std::uniform_real_distribution<float> velocity(-50.0f, 50.0f);
+    scene.positions.resize(count);
+    scene.velocities.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        scene.positions[i] = glm::vec2(position(random), position(random));
+        scene.velocities[i] = glm::vec2(velocity(random), velocity(random));
+    }
+    return scene;
+}
+
+// Returns the proxy of every box, the tree allocates its inner nodes from the same array
+static std::vector<int> BuildTree(const SpatialScene &scene, AabbTree &tree)
+{
+    std::vector<int> proxies(scene.positions.size());
+    for (size_t i = 0; i < proxies.size(); i++)
+    {
+        proxies[i] = tree.CreateProxy(scene.GetBox(i), static_cast<int>(i));
+    }
+    return proxies;
+}
+
+// Query origins, the same ones for the tree and for brute force
+static std::vector<glm::vec2> CreateQueryPoints(const SpatialScene &scene)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(0.0f, scene.worldSize);
+    std::vector<glm::vec2> points(QUERY_COUNT);
+    for (auto &point : points)
+    {
+        point = glm::vec2(position(random), position(random));
+    }
+    return points;
+}
+
+static glm::vec2 GetRayDirection(size_t query)
+{
+    const auto angle = static_cast<float>(query) * 2.39996f;
+    return glm::vec2(std::cos(angle), std::sin(angle));
+}
+
+void AddSpatialBenchmarks(BenchmarkRunner &runner)
+{
+    // Per box
+    runner.Add("AabbTree build", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   const auto scene = CreateScene(count);
+                   AabbTree tree;
+                   timer.Start();
+                   BuildTree(scene, tree);
+                   timer.Stop();
+                   DoNotOptimize(tree.GetHeight());
+                   return count;
+               });
+
+    // Per box and tick, every box moves every tick like in SpatialSystem::Update
+    runner.Add("AabbTree move", BENCHMARK_SIZES,
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   auto scene = CreateScene(count);
+                   AabbTree tree;
+                   const auto proxies = BuildTree(scene, tree);
+                   size_t reinsertions = 0;
+                   for (int tick = 0; tick < SPATIAL_BENCHMARK_TICKS; tick++)
+                   {
+                       for (size_t i = 0; i < count; i++)
+                       {
+                           scene.positions[i] += scene.velocities[i] * (1.0f / 60.0f);
+                       }
+                       timer.Start();
+                       for (size_t i = 0; i < count; i++)
+                       {
+                           reinsertions += tree.MoveProxy(proxies[i], scene.GetBox(i)) ? 1 : 0;
+                       }
+                       timer.Stop();
+                   }
+                   DoNotOptimize(reinsertions);
+                   return count * SPATIAL_BENCHMARK_TICKS;
+               });
+
+    // Per query. The brute force versions test every box, what a system without the tree does
+    runner.Add("AabbTree QueryRectangle", {10000, 100000, 1000000},
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   const auto scene = CreateScene(count);
+                   const auto points = CreateQueryPoints(scene);
+                   AabbTree tree;
+                   BuildTree(scene, tree);
+                   size_t found = 0;
+                   timer.Start();
+                   for (const auto &point : points)
+                   {
+                       tree.QueryRectangle({point, point + QUERY_AREA}, [&](int) { found++; });
+                   }
+                   timer.Stop();
+                   DoNotOptimize(found);
+                   return points.size();
+               });
+
+    runner.Add("Brute force QueryRectangle", {10000, 100000, 1000000},
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   const auto scene = CreateScene(count);
+                   const auto points = CreateQueryPoints(scene);
+                   size_t found = 0;
+                   timer.Start();
+                   for (const auto &point : points)
+                   {
+                       const Aabb area = {point, point + QUERY_AREA};
+                       for (size_t i = 0; i < count; i++)
+                       {
+                           found += area.Overlaps(scene.GetBox(i)) ? 1 : 0;
+                       }
+                   }
+                   timer.Stop();
+                   DoNotOptimize(found);
+                   return points.size();
+               });
+
+    runner.Add("AabbTree QueryRadius", {10000, 100000, 1000000},
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   const auto scene = CreateScene(count);
+                   const auto points = CreateQueryPoints(scene);
+                   AabbTree tree;
+                   BuildTree(scene, tree);
+                   size_t found = 0;
+                   timer.Start();
+                   for (const auto &point : points)
+                   {
+                       tree.QueryRadius(point, QUERY_RADIUS, [&](int) { found++; });
+                   }
+                   timer.Stop();
+                   DoNotOptimize(found);
+                   return points.size();
+               });
+
+    runner.Add("Brute force QueryRadius", {10000, 100000, 1000000},
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   const auto scene = CreateScene(count);
+                   const auto points = CreateQueryPoints(scene);
+                   size_t found = 0;
+                   timer.Start();
+                   for (const auto &point : points)
+                   {
+                       for (size_t i = 0; i < count; i++)
+                       {
+                           found += scene.GetBox(i).GetDistanceSquared(point) <= QUERY_RADIUS * QUERY_RADIUS ? 1 : 0;
+                       }
+                   }
+                   timer.Stop();
+                   DoNotOptimize(found);
+                   return points.size();
+               });
+
+    runner.Add("AabbTree Raycast", {10000, 100000, 1000000},
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   const auto scene = CreateScene(count);
+                   const auto points = CreateQueryPoints(scene);
+                   AabbTree tree;
+                   BuildTree(scene, tree);
+                   size_t hits = 0;
+                   timer.Start();
+                   for (size_t query = 0; query < points.size(); query++)
+                   {
+                       RaycastHit hit;
+                       hits += tree.Raycast(points[query], GetRayDirection(query), RAY_LENGTH, hit) ? 1 : 0;
+                   }
+                   timer.Stop();
+                   DoNotOptimize(hits);
+                   return points.size();
+               });
+
+    runner.Add("Brute force Raycast", {10000, 100000, 1000000},
+               [](size_t count, BenchmarkTimer &timer)
+               {
+                   const auto scene = CreateScene(count);
+                   const auto points = CreateQueryPoints(scene);
+                   // The slab test the tree runs on its nodes, against every box
+                   size_t hits = 0;
+                   timer.Start();
+                   for (size_t query = 0; query < points.size(); query++)
+                   {
+                       const auto origin = points[query];
+                       const auto direction = GetRayDirection(query);
+                       auto closest = RAY_LENGTH;
+                       auto found = false;
+                       for (size_t i = 0; i < count; i++)
+                       {
+                           const auto box = scene.GetBox(i);
+                           auto enter = 0.0f;
+                           auto exit = closest;
+                           for (int axis = 0; axis < 2 && enter <= exit; axis++)
+                           {
+                               if (direction[axis] == 0.0f)
+                               {
+                                   exit = origin[axis] < box.min[axis] || origin[axis] > box.max[axis] ? -1.0f : exit;
+                                   continue;
+                               }
+                               auto slabEnter = (box.min[axis] - origin[axis]) / direction[axis];
+                               auto slabExit = (box.max[axis] - origin[axis]) / direction[axis];
+                               if (slabEnter > slabExit)
+                               {
+                                   std::swap(slabEnter, slabExit);
+                               }
+                               enter = std::max(enter, slabEnter);
+                               exit = std::min(exit, slabExit);
+                           }
+                           if (enter <= exit)
+                           {
+                               closest = enter;
+                               found = true;
+                           }
+                       }
+                       hits += found ? 1 : 0;
+                   }
+                   timer.Stop();
+                   DoNotOptimize(hits);
+                   return points.size();
+               });
+}
@@ -1,11 +1,13 @@
 #include "AssetStore.hpp"
 #include "../Logger/Logger.hpp"
+#include "../Memory/AllocationTracker.hpp"
+#include "../Profiler/Profiler.hpp"
 
 #include <SDL_image.h>
 
-AssetStore::AssetStore() { Logger::Log("AssetStore constructor called"); }
+AssetStore::AssetStore() { LOGGER_LOG("AssetStore constructor called"); }
 
-AssetStore::~AssetStore() { Logger::Log("AssetStore destructor called!"); }
+AssetStore::~AssetStore() { LOGGER_LOG("AssetStore destructor called!"); }
 
 void AssetStore::ClearAssets()
 {
@@ -14,18 +16,73 @@ void AssetStore::ClearAssets()
         SDL_DestroyTexture(texture.second);
     }
     textures.clear();
+    textureSizes.clear();
+    textureFiles.clear();
 }
 
 void AssetStore::AddTexture(SDL_Renderer *renderer, const std::string &assetId, const std::string &filePath)
 {
+    PROFILE_SCOPE("AssetStore::AddTexture");
+    ALLOCATION_SCOPE(ALLOC_ASSETS);
+
     SDL_Surface *surface = IMG_Load(filePath.c_str());
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (!surface)
+    {
+        // A texture that is already loaded stays as it is
+        LOGGER_ERR("Failed to load texture {}: {}", filePath, SDL_GetError());
+        return;
+    }
+    textureSizes[assetId] = SDL_Point{surface->w, surface->h};
+    textureFiles[assetId] = filePath;
+
+    if (renderer)
+    {
+        SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+
+        // Add the texture to the map, replacing the one with the same id
+        auto &slot = textures[assetId];
+        if (slot)
+        {
+            SDL_DestroyTexture(slot);
+        }
+        slot = texture;
+    }
     SDL_FreeSurface(surface);
 
-    // Add the texture to the map
-    textures.emplace(assetId, texture);
+    LOGGER_LOG("New texture added to the Asset Store with id = {}", assetId);
+}
 
-    Logger::Log("New texture added to the Asset Store with id = " + assetId);
+bool AssetStore::ReloadTextures(SDL_Renderer *renderer, const std::string &filePath)
+{
+    auto reloaded = false;
+    for (const auto &textureFile : textureFiles)
+    {
+        if (textureFile.second == filePath)
+        {
+            // Only replaces the value of the entry, the map is not modified while walking it
+            AddTexture(renderer, textureFile.first, filePath);
+            reloaded = true;
+        }
+    }
+    return reloaded;
 }
 
 SDL_Texture *AssetStore::GetTexture(const std::string &assetId) { return textures[assetId]; }
+
+size_t AssetStore::GetTextureCount() const { return textureSizes.size(); }
+
+size_t AssetStore::GetTextureMemoryUsage() const
+{
+    size_t bytes = 0;
+    for (const auto &size : textureSizes)
+    {
+        bytes += static_cast<size_t>(size.second.x) * size.second.y * 4;
+    }
+    return bytes;
+}
+
+SDL_Point AssetStore::GetTextureSize(const std::string &assetId) const
+{
+    auto size = textureSizes.find(assetId);
+    return size != textureSizes.end() ? size->second : SDL_Point{0, 0};
+}
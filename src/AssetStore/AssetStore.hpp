@@ -8,6 +8,10 @@ class AssetStore
 {
   private:
     std::map<std::string, SDL_Texture *> textures;
+    // Width and height of every texture, also kept when running without a renderer
+    std::map<std::string, SDL_Point> textureSizes;
+    // File every texture was loaded from, used to reload it when the file changes
+    std::map<std::string, std::string> textureFiles;
     // TODO: create a map for fonts
     // TODO: create a map for audio
   public:
@@ -15,6 +19,16 @@ class AssetStore
     ~AssetStore();
 
     void ClearAssets();
+    // With a null renderer only the image size is recorded, this is used when running headless.
+    // Adding an existing id replaces its texture
     void AddTexture(SDL_Renderer *renderer, const std::string &, const std::string &filePath);
+    // Loads every texture that came from the file again, entities keep referring
+    // to them by id. Returns false if no texture uses the file
+    bool ReloadTextures(SDL_Renderer *renderer, const std::string &filePath);
     SDL_Texture *GetTexture(const std::string &assetId);
+    SDL_Point GetTextureSize(const std::string &assetId) const;
+
+    size_t GetTextureCount() const;
+    // Estimated from the texture sizes at 4 bytes per pixel
+    size_t GetTextureMemoryUsage() const;
 };
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+struct BoxColliderComponent
+{
+    // Size of the box before the transform's scale is applied
+    int width;
+    int height;
+    // Position of the box relative to the transform's position
+    glm::vec2 offset;
+
+    BoxColliderComponent(int width = 0, int height = 0, glm::vec2 offset = glm::vec2(0, 0))
+    {
+        this->width = width;
+        this->height = height;
+        this->offset = offset;
+    }
+};
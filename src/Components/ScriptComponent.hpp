@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+struct ScriptComponent
+{
+    // Name of a behavior registered from Lua with register_behavior()
+    std::string behavior;
+    // Index of the behavior in the ScriptSystem, resolved on the first update.
+    // -1 while unresolved, -2 if no such behavior was registered
+    int behaviorIndex;
+
+    ScriptComponent(std::string behavior = "")
+    {
+        this->behavior = behavior;
+        this->behaviorIndex = -1;
+    }
+};
@@ -8,10 +8,18 @@ struct TransformComponent
     glm::vec2 scale;
     double rotation;
 
+    // State at the previous simulation tick, the renderer interpolates between
+    // it and the current state. Code that teleports an entity should set these
+    // as well, otherwise the entity slides to its new position over one tick
+    glm::vec2 previousPosition;
+    double previousRotation;
+
     TransformComponent(glm::vec2 position = glm::vec2(0, 0), glm::vec2 scale = glm::vec2(1, 1), double rotation = 0.0)
     {
         this->position = position;
         this->scale = scale;
         this->rotation = rotation;
+        this->previousPosition = position;
+        this->previousRotation = rotation;
     }
 };
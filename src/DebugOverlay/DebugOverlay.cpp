@@ -0,0 +1,175 @@
+#include "DebugOverlay.hpp"
+#include "../Memory/AllocationTracker.hpp"
+#include "../Profiler/Profiler.hpp"
+#include "../Systems/CollisionSystem.hpp"
+#include "../Systems/SpatialSystem.hpp"
+#include "../Systems/ScriptSystem.hpp"
+
+#include <chrono>
+#include <imgui/imgui.h>
+#include <imgui/imgui_sdl.h>
+
+void DebugOverlay::Initialize(SDL_Renderer *renderer, int windowWidth, int windowHeight)
+{
+    ImGui::CreateContext();
+    ImGui::GetIO().IniFilename = nullptr;
+    ImGuiSDL::Initialize(renderer, windowWidth, windowHeight);
+    isInitialized = true;
+}
+
+void DebugOverlay::Destroy()
+{
+    if (!isInitialized)
+    {
+        return;
+    }
+    ImGuiSDL::Deinitialize();
+    ImGui::DestroyContext();
+    isInitialized = false;
+}
+
+void DebugOverlay::Toggle() { isVisible = !isVisible; }
+
+bool DebugOverlay::IsVisible() const { return isVisible; }
+
+void DebugOverlay::ProcessInput(const Input &input)
+{
+    const auto &state = input.GetState();
+    mouseX = state.mouseX;
+    mouseY = state.mouseY;
+    mouseButtons = state.mouseButtons;
+    // Frames without a render (none while hidden) must not lose the wheel movement
+    mouseWheel += state.mouseWheel;
+    inputLatency = input.GetLatencyStats();
+}
+
+void DebugOverlay::Render(double deltaTime, const Registry &registry, const AssetStore &assetStore,
+                          const FramePacer &framePacer, const FrameArena &frameArena,
+                          const ScriptRuntime &scriptRuntime, int drawCalls)
+{
+    if (!isInitialized || !isVisible)
+    {
+        return;
+    }
+    PROFILE_SCOPE("DebugOverlay::Render");
+    const auto start = std::chrono::steady_clock::now();
+
+    auto &io = ImGui::GetIO();
+    io.DeltaTime = deltaTime > 0.0 ? static_cast<float>(deltaTime) : 1.0f / 60.0f;
+    io.MousePos = ImVec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
+    io.MouseDown[0] = mouseButtons & SDL_BUTTON(SDL_BUTTON_LEFT);
+    io.MouseDown[1] = mouseButtons & SDL_BUTTON(SDL_BUTTON_RIGHT);
+    io.MouseWheel = mouseWheel;
+    mouseWheel = 0.0f;
+
+    ImGui::NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    ImGui::Begin("Performance");
+
+    // Frame times
+    const auto frameTimes = framePacer.GetFrameTimes();
+    const auto stats = framePacer.GetStats();
+    ImGui::Text("Frame: avg %.2f ms  p50 %.2f ms  p99 %.2f ms  max %.2f ms", stats.average, stats.p50, stats.p99,
+                stats.max);
+    ImGui::PlotLines("##frametimes", frameTimes.data(), static_cast<int>(frameTimes.size()), 0, "frame time (ms)", 0.0f,
+                     40.0f, ImVec2(0, 60));
+    ImGui::Text("Overlay: %.3f ms", lastOverlayMilliseconds);
+    ImGui::Text("Input latency (worst case): avg %.2f ms  max %.2f ms (%zu samples)", inputLatency.average,
+                inputLatency.max, inputLatency.samples);
+
+    // Per-system timings of the last frame
+    if (ImGui::CollapsingHeader("Zones", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+#ifdef ENABLE_PROFILER
+        for (const auto &zone : Profiler::GetLastFrame())
+        {
+            ImGui::Text("%*s%s  %.3f ms (%u)", static_cast<int>(zone.depth * 2), "", zone.name, zone.milliseconds,
+                        zone.calls);
+        }
+#else
+        ImGui::TextDisabled("Build with make PROFILE=1 to see zone timings");
+#endif
+    }
+
+    // ECS
+    if (ImGui::CollapsingHeader("Entities", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        ImGui::Text("Entities: %d", registry.GetNumEntities());
+        if (registry.HasSystem<CollisionSystem>())
+        {
+            const auto &collisionSystem = registry.GetSystem<CollisionSystem>();
+            ImGui::Text("Colliders: %zu, overlapping pairs: %zu", collisionSystem.GetSystemEntities().size(),
+                        collisionSystem.GetCollisions().size());
+        }
+        if (registry.HasSystem<SpatialSystem>())
+        {
+            const auto &spatialSystem = registry.GetSystem<SpatialSystem>();
+            const auto &tree = spatialSystem.GetTree();
+            ImGui::Text("Spatial tree: %zu proxies, height %d, %zu reinserted", tree.GetProxyCount(),
+                        tree.GetHeight(), spatialSystem.GetReinsertions());
+        }
+        for (size_t componentId = 0; componentId < registry.GetNumComponentTypes(); componentId++)
+        {
+            const auto pool = registry.GetComponentPoolStats(componentId);
+            if (pool.name)
+            {
+                ImGui::Text("[%zu] %s: %zu components, %zu slots", componentId, pool.name, pool.components,
+                            pool.capacity);
+            }
+        }
+    }
+
+    // Lua behaviors and the Lua heap
+    if (ImGui::CollapsingHeader("Scripts", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        if (registry.HasSystem<ScriptSystem>())
+        {
+            for (const auto &script : registry.GetSystem<ScriptSystem>().GetStats())
+            {
+                ImGui::Text("%s: %zu  %.3f ms", script.name, script.entities, script.milliseconds);
+            }
+        }
+        const auto memory = scriptRuntime.GetMemoryStats();
+        ImGui::Text("Lua memory: %.1f KB, pool pages %.1f KB", memory.luaBytes / 1024.0,
+                    memory.allocator.pageBytes / 1024.0);
+        ImGui::Text("GC: %zu steps %.3f ms, %zu cycles, %zu forced", memory.steps, memory.milliseconds,
+                    memory.completedCycles, memory.emergencyCollections);
+    }
+
+    // Assets and rendering
+    if (ImGui::CollapsingHeader("Rendering", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        ImGui::Text("Textures: %zu (%.2f MB)", assetStore.GetTextureCount(),
+                    assetStore.GetTextureMemoryUsage() / (1024.0 * 1024.0));
+        ImGui::Text("Draw calls: %d", drawCalls);
+        ImGui::Text("Frame arena: %zu / %zu bytes", frameArena.GetUsed(), frameArena.GetCapacity());
+    }
+
+    // Heap allocations of the previous frame per subsystem, and the bytes each one holds
+    if (ImGui::CollapsingHeader("Allocations"))
+    {
+        if (AllocationTracker::IsEnabled())
+        {
+            for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++)
+            {
+                const auto counters = AllocationTracker::GetLastFrame(static_cast<AllocationTag>(tag));
+                const auto total = AllocationTracker::GetTotal(static_cast<AllocationTag>(tag));
+                ImGui::Text("%-10s %6zu allocs %10zu bytes %6zu frees %10zu live",
+                            AllocationTracker::GetTagName(static_cast<AllocationTag>(tag)), counters.allocations,
+                            counters.bytes, counters.frees, total.bytes - total.freedBytes);
+            }
+        }
+        else
+        {
+            ImGui::TextDisabled("Build with make TRACK_ALLOCATIONS=1 to see allocations");
+        }
+    }
+
+    ImGui::End();
+    ImGui::Render();
+    ImGuiSDL::Render(ImGui::GetDrawData());
+
+    lastOverlayMilliseconds =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../AssetStore/AssetStore.hpp"
+#include "../ECS/ECS.hpp"
+#include "../FramePacer/FramePacer.hpp"
+#include "../Input/Input.hpp"
+#include "../Memory/FrameArena.hpp"
+#include "../ScriptRuntime/ScriptRuntime.hpp"
+#include <SDL.h>
+
+//////////////////////////////////////////////////////////////////////////////////
+// DebugOverlay
+//////////////////////////////////////////////////////////////////////////////////
+// Dear ImGui window with frame times, per-system timings, ECS and asset
+// statistics. While it is hidden Render() returns right away, so it costs
+// nothing outside of the debugging session
+//////////////////////////////////////////////////////////////////////////////////
+class DebugOverlay
+{
+  private:
+    bool isInitialized = false;
+    bool isVisible = false;
+    // Dear ImGui has no SDL input backend here, it gets the mouse from Input
+    int mouseX = 0;
+    int mouseY = 0;
+    uint32_t mouseButtons = 0;
+    float mouseWheel = 0.0f;
+    InputLatencyStats inputLatency;
+
+    // Time spent building and drawing the overlay in the previous frame
+    double lastOverlayMilliseconds = 0.0;
+
+  public:
+    DebugOverlay() = default;
+    ~DebugOverlay() = default;
+
+    void Initialize(SDL_Renderer *renderer, int windowWidth, int windowHeight);
+    void Destroy();
+
+    void Toggle();
+    bool IsVisible() const;
+
+    // Takes the mouse state and input statistics, once per frame after Input::Poll()
+    void ProcessInput(const Input &input);
+
+    void Render(double deltaTime, const Registry &registry, const AssetStore &assetStore, const FramePacer &framePacer,
+                const FrameArena &frameArena, const ScriptRuntime &scriptRuntime, int drawCalls);
+};
@@ -1,5 +1,6 @@
 #include "ECS.hpp"
 #include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
 
 #include <algorithm>
 #include <vector>
@@ -8,6 +9,8 @@ int IComponent::nextId = 0;
 
 int Entity::GetId() const { return id; }
 
+void Entity::Kill() { registry->KillEntity(*this); }
+
 void System::AddEntityToSystem(Entity entity)
 {
     // add entity to the end of the vector
@@ -27,28 +30,71 @@ void System::RemoveEntityFromSystem(Entity entity)
     //               });
 }
 
-std::vector<Entity> System::GetSystemEntities() const { return entities; }
+const std::vector<Entity> &System::GetSystemEntities() const { return entities; }
 
 const Signature &System::GetComponentSignature() const { return componentSignature; }
 
 Entity Registry::CreateEntity()
 {
+    ALLOCATION_SCOPE(ALLOC_ECS);
     int entityId;
 
-    entityId = numEntities++;
+    if (freeIds.empty())
+    {
+        // No free ids to reuse, hand out a new one. The per-entity arrays always
+        // hold numEntities elements, push_back grows them geometrically
+        entityId = numEntities++;
+        entityComponentSignatures.emplace_back();
+        entityFlags.push_back(0);
+    }
+    else
+    {
+        // Reuse an id from a previously killed entity
+        entityId = freeIds.front();
+        freeIds.pop_front();
+        entityFlags[entityId] = 0;
+    }
 
     Entity entity(entityId);
     entity.registry = this;
-    entitiesToBeAdded.insert(entity);
+    entitiesToBeAdded.push_back(entity);
+
+    LOGGER_LOG("Entity created with id = {}", entityId);
+
+    return entity;
+}
 
-    if (entityId >= entityComponentSignatures.size())
+void Registry::Reserve(size_t entities)
+{
+    ALLOCATION_SCOPE(ALLOC_ECS);
+    reservedEntities = std::max(reservedEntities, entities);
+    entityComponentSignatures.reserve(entities);
+    entityFlags.reserve(entities);
+    for (auto &pool : componentPools)
     {
-        entityComponentSignatures.resize(entityId + 1);
+        if (pool)
+        {
+            pool->Reserve(entities);
+        }
     }
+}
 
-    Logger::Log("Entity created with id = " + std::to_string(entityId));
+void Registry::KillEntity(Entity entity)
+{
+    auto &flags = entityFlags[entity.GetId()];
+    if (flags & (ENTITY_PENDING_KILL | ENTITY_FREE))
+    {
+        return;
+    }
+    flags |= ENTITY_PENDING_KILL;
+    entitiesToBeKilled.push_back(entity);
+    LOGGER_LOG("Entity with id = {} will be killed", entity.GetId());
+}
 
-    return entity;
+bool Registry::IsAlive(Entity entity) const
+{
+    const auto entityId = entity.GetId();
+    return entityId >= 0 && entityId < numEntities && !(entityFlags[entityId] & (ENTITY_PENDING_KILL | ENTITY_FREE));
 }
 
 void Registry::AddEntityToSystem(Entity entity)
@@ -72,14 +118,105 @@ void Registry::AddEntityToSystem(Entity entity)
     }
 }
 
+int Registry::GetNumEntities() const { return numEntities - static_cast<int>(freeIds.size()); }
+
+size_t Registry::GetNumComponentTypes() const { return componentPools.size(); }
+
+ComponentPoolStats Registry::GetComponentPoolStats(size_t componentId) const
+{
+    if (componentId >= componentPools.size() || !componentPools[componentId])
+    {
+        return {nullptr, 0, 0};
+    }
+    return {componentNames[componentId], componentCounts[componentId], componentPools[componentId]->GetSize()};
+}
+
+void Registry::RemoveEntityFromSystems(Entity entity)
+{
+    for (auto &system : systems)
+    {
+        system.second->RemoveEntityFromSystem(entity);
+    }
+}
+
 void Registry::Update()
 {
-    // Add the entities that are waiting to be created to the active Systems
-    for (auto entity : entitiesToBeAdded)
+    PROFILE_SCOPE("Registry::Update");
+    ALLOCATION_SCOPE(ALLOC_ECS);
+
+    // Add the entities that are waiting to be created to the active Systems.
+    // Systems are the outer loop so every system is only touched once per batch
+    if (!entitiesToBeAdded.empty())
+    {
+        for (auto &system : systems)
+        {
+            const auto &systemComponentSignature = system.second->GetComponentSignature();
+            for (auto entity : entitiesToBeAdded)
+            {
+                const auto &entityComponentSignature = entityComponentSignatures[entity.GetId()];
+                if ((entityComponentSignature & systemComponentSignature) == systemComponentSignature)
+                {
+                    system.second->AddEntityToSystem(entity);
+                }
+            }
+        }
+        entitiesToBeAdded.clear();
+    }
+
+    // Before the kills, they only destroy the components still in the signature
+    if (!componentsToBeRemoved.empty())
+    {
+        for (auto &system : systems)
+        {
+            const auto &systemComponentSignature = system.second->GetComponentSignature();
+            system.second->RemoveEntitiesFromSystem(
+                [&](Entity entity)
+                {
+                    const auto &entityComponentSignature = entityComponentSignatures[entity.GetId()];
+                    return (entityComponentSignature & systemComponentSignature) != systemComponentSignature;
+                });
+        }
+        for (const auto &removal : componentsToBeRemoved)
+        {
+            // Unless the component was added again, the new one has replaced the old one then
+            if (!entityComponentSignatures[removal.entityId].test(removal.componentId))
+            {
+                componentPools[removal.componentId]->Remove(removal.entityId);
+            }
+        }
+        componentsToBeRemoved.clear();
+    }
+
+    if (entitiesToBeKilled.empty())
+    {
+        return;
+    }
+
+    // Remove the entities that are waiting to be killed from the active
+    // Systems, one pass over each system for the whole batch
+    for (auto &system : systems)
     {
-        AddEntityToSystem(entity);
+        system.second->RemoveEntitiesFromSystem([this](Entity entity)
+                                                { return entityFlags[entity.GetId()] & ENTITY_PENDING_KILL; });
     }
-    entitiesToBeAdded.clear();
 
-    // TODO: Remove the entities that are waiting to be killed from the active Systems
+    for (auto entity : entitiesToBeKilled)
+    {
+        entityFlags[entity.GetId()] = ENTITY_FREE;
+
+        auto &signature = entityComponentSignatures[entity.GetId()];
+        for (size_t componentId = 0; componentId < componentCounts.size(); componentId++)
+        {
+            if (signature.test(componentId))
+            {
+                componentCounts[componentId]--;
+                componentPools[componentId]->Remove(entity.GetId());
+            }
+        }
+        signature.reset();
+
+        // Make the entity id available to be reused
+        freeIds.push_back(entity.GetId());
+    }
+    entitiesToBeKilled.clear();
 }
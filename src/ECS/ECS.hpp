@@ -1,9 +1,14 @@
 #pragma once
 
 #include "../Logger/Logger.hpp"
+#include "../Memory/AllocationTracker.hpp"
+#include <algorithm>
 #include <bitset>
+#include <deque>
+#include <cstdint>
 #include <memory>
-#include <set>
+#include <new>
+#include <tuple>
 #include <typeindex>
 #include <unordered_map>
 #include <vector>
@@ -45,6 +50,7 @@ class Entity
     Entity(int id) : id(id){};
     Entity(const Entity &entity) = default;
     int GetId() const;
+    void Kill();
 
     Entity &operator=(const Entity &other) = default;
     bool operator==(const Entity &other) const { return id == other.id; }
@@ -66,6 +72,7 @@ class Entity
 //////////////////////////////////////////////////////////////////////////////////
 // The system processes entities that contain a specific signature
 //////////////////////////////////////////////////////////////////////////////////
+template <typename T> class Pool;
 
 class System
 {
@@ -73,13 +80,27 @@ class System
     Signature componentSignature;
     std::vector<Entity> entities;
 
+    friend class Registry;
+
+  protected:
+    // The registry that owns the system, set by Registry::AddSystem()
+    class Registry *registry = nullptr;
+
+    // Typed access to the pool of a component. Fetch it once at the start of an
+    // update and index it with the entity ids instead of calling
+    // Entity::GetComponent() for every entity
+    template <typename TComponent> Pool<TComponent> &GetPool() const;
+
   public:
     System() = default;
-    ~System() = default;
+    // The registry owns the systems through pointers to this base class
+    virtual ~System() = default;
 
     void AddEntityToSystem(Entity entity);
     void RemoveEntityFromSystem(Entity entity);
-    std::vector<Entity> GetSystemEntities() const;
+    // Removes every entity for which shouldRemove(entity) is true in a single pass
+    template <typename TPredicate> void RemoveEntitiesFromSystem(TPredicate shouldRemove);
+    const std::vector<Entity> &GetSystemEntities() const;
     const Signature &GetComponentSignature() const;
 
     // Define the component Type T that entities must have to be
@@ -90,41 +111,166 @@ class System
 //////////////////////////////////////////////////////////////////////////////////
 // Pool
 //////////////////////////////////////////////////////////////////////////////////
-// A pool is just a vector (contiguous data) of objects of type T
+// A pool is a contiguous block of storage for objects of type T, indexed by
+// entity id. Slots start out uninitialized, components are constructed in
+// place when they are added and destroyed when they are removed, so adding a
+// component costs exactly one construction and T does not need to be default
+// constructible or copyable.
+// The storage at least doubles whenever it has to grow, so adds are amortized
+// O(1). Reserve() sizes it up front when the number of entities is known
 //////////////////////////////////////////////////////////////////////////////////
 class IPool
 {
   public:
     virtual ~IPool() {}
+    // Number of slots allocated
+    virtual size_t GetSize() const = 0;
+    // Grows the storage to at least n slots
+    virtual void Reserve(size_t n) = 0;
+    // Destroys the object at index, if there is one
+    virtual void Remove(int index) = 0;
 };
 
 template <typename T> class Pool : public IPool
 {
   private:
-    std::vector<T> data;
+    std::allocator<T> allocator;
+    T *data = nullptr;
+    size_t capacity = 0;
+    // One bit per slot, set when the slot holds a constructed object
+    std::vector<bool> occupied;
 
   public:
-    Pool(int size = 100) { data.resize(size); }
+    Pool() = default;
+
+    virtual ~Pool()
+    {
+        Clear();
+        allocator.deallocate(data, capacity);
+    }
+
+    Pool(const Pool &) = delete;
+    Pool &operator=(const Pool &) = delete;
+
+    size_t GetSize() const override { return capacity; }
 
-    virtual ~Pool() = default;
+    bool Has(int index) const { return index < static_cast<int>(capacity) && occupied[index]; }
 
-    bool isEmpty() const { return data.empty(); }
+    // Live objects are moved over to the new storage
+    void Reserve(size_t newCapacity) override
+    {
+        if (newCapacity <= capacity)
+        {
+            return;
+        }
+        T *newData = allocator.allocate(newCapacity);
+        for (size_t i = 0; i < capacity; i++)
+        {
+            if (occupied[i])
+            {
+                new (newData + i) T(std::move(data[i]));
+                data[i].~T();
+            }
+        }
+        allocator.deallocate(data, capacity);
+        data = newData;
+        capacity = newCapacity;
+        occupied.resize(newCapacity, false);
+    }
 
-    size_t GetSize() const { return data.size(); }
+    // Makes room for at least n slots, at least doubling the storage if it has to grow
+    void Grow(size_t n)
+    {
+        if (n > capacity)
+        {
+            Reserve(std::max(n, capacity * 2));
+        }
+    }
 
-    void Resize(int n) { data.resize(n); }
+    // Destroys every object, the storage is kept
+    void Clear()
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            if (occupied[i])
+            {
+                data[i].~T();
+                occupied[i] = false;
+            }
+        }
+    }
 
-    void Clear() { data.clear(); }
+    // Constructs a T from args directly in the slot, replacing the previous
+    // object if there was one. The arguments must not refer to that object
+    template <typename... TArgs> T &Emplace(int index, TArgs &&...args)
+    {
+        Grow(index + 1);
+        Remove(index);
+        T *object = new (data + index) T(std::forward<TArgs>(args)...);
+        occupied[index] = true;
+        return *object;
+    }
 
-    void Add(T object) { data.push_back(object); }
+    void Remove(int index) override
+    {
+        if (Has(index))
+        {
+            data[index].~T();
+            occupied[index] = false;
+        }
+    }
 
-    void Set(int index, T object) { data[index] = object; }
+    // Copies object into count consecutive slots starting at first
+    void Fill(int first, int count, const T &object)
+    {
+        Grow(first + count);
+        for (int i = first; i < first + count; i++)
+        {
+            Remove(i);
+            new (data + i) T(object);
+            occupied[i] = true;
+        }
+    }
 
-    T &Get(int index) { return static_cast<T &>(data[index]); }
+    T &Get(int index) { return data[index]; }
+    const T &Get(int index) const { return data[index]; }
 
     T &operator[](unsigned int index) { return data[index]; }
 };
 
+//////////////////////////////////////////////////////////////////////////////////
+// Prefab
+//////////////////////////////////////////////////////////////////////////////////
+// A template for entities that share the same set of components. The
+// signature is computed once and new entities start out as copies of the
+// stored components, see Registry::CreateEntities()
+//////////////////////////////////////////////////////////////////////////////////
+template <typename... TComponents> class Prefab
+{
+  private:
+    std::tuple<TComponents...> components;
+    Signature signature;
+
+  public:
+    Prefab(TComponents... components) : components(std::move(components)...)
+    {
+        (signature.set(Component<TComponents>::GetId()), ...);
+    }
+
+    const std::tuple<TComponents...> &GetComponents() const { return components; }
+    const Signature &GetSignature() const { return signature; }
+};
+
+struct ComponentPoolStats
+{
+    // Compiler specific type name, nullptr if the pool does not exist
+    const char *name;
+    // Number of entities that have the component
+    size_t components;
+    // Number of slots allocated in the pool
+    size_t capacity;
+};
+
 //////////////////////////////////////////////////////////////////////////////////
 // Registry
 //////////////////////////////////////////////////////////////////////////////////
@@ -137,9 +283,17 @@ class Registry
     // Keep track of how many entities were added to the scene
     int numEntities = 0;
 
+    // Number of entities set with Reserve(), new pools start out with this many slots
+    size_t reservedEntities = 0;
+
     // Vector of component polls, each pool contains all the data for a certain
-    // component Vector index = component type id Pool index = entity id
-    std::vector<std::shared_ptr<IPool>> componentPools;
+    // component Vector index = component type id Pool index = entity id.
+    // The registry is the only owner, everyone else uses plain pointers
+    std::vector<std::unique_ptr<IPool>> componentPools;
+
+    // Debug information per component type (vector index = component type id)
+    std::vector<const char *> componentNames;
+    std::vector<size_t> componentCounts;
 
     // Vector of component signatures
     // The signature let's us know which components are turned "on" for an entity
@@ -147,32 +301,78 @@ class Registry
     std::vector<Signature> entityComponentSignatures;
 
     // Map of active systems (index = system typeid)
-    std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
+    std::unordered_map<std::type_index, std::unique_ptr<System>> systems;
 
-    // Set of entities that are flagged to be added or removed in the next
-    // registry Update()
-    std::set<Entity> entitiesToBeAdded;
-    std::set<Entity> entitiesToBeKilled;
+    // Entities that are flagged to be added or removed in the next registry
+    // Update(). Flat append-only lists, an entity is only queued for killing
+    // once thanks to the ENTITY_PENDING_KILL flag
+    std::vector<Entity> entitiesToBeAdded;
+    std::vector<Entity> entitiesToBeKilled;
+
+    // Components removed since the last Update(). They are destroyed there, after
+    // the systems that required them have let go of the entity
+    struct ComponentRemoval
+    {
+        int entityId;
+        size_t componentId;
+    };
+    std::vector<ComponentRemoval> componentsToBeRemoved;
+
+    // State flags per entity (vector index = entity id)
+    enum EntityFlags : uint8_t
+    {
+        ENTITY_PENDING_KILL = 1 << 0,
+        // Killed, the id waits in freeIds to be reused
+        ENTITY_FREE = 1 << 1,
+    };
+    std::vector<uint8_t> entityFlags;
+
+    // Ids of killed entities, reused by CreateEntity()
+    std::deque<int> freeIds;
 
   public:
-    Registry() { Logger::Log("Registry constructor called"); }
+    Registry() { LOGGER_LOG("Registry constructor called"); }
 
-    ~Registry() { Logger::Log("Registry descructor called"); }
+    ~Registry() { LOGGER_LOG("Registry descructor called"); }
 
     // The registry Update() finally processes the entities that are waiting to be
     // added/killed
     void Update();
 
+    // Preallocates room for the given number of entities in the registry and in
+    // every component pool, including pools created later on
+    void Reserve(size_t entities);
+
     // Entity management
     Entity CreateEntity();
 
+    // Creates count entities with consecutive ids from a prefab and returns the
+    // first one. initialize(index, components &...) is called for every new
+    // entity with references to its components, in the prefab's order
+    template <typename... TComponents, typename TInitializer>
+    Entity CreateEntities(size_t count, const Prefab<TComponents...> &prefab, TInitializer initialize);
+    template <typename... TComponents> Entity CreateEntities(size_t count, const Prefab<TComponents...> &prefab);
+
+    void KillEntity(Entity entity);
+    // False for ids that were never handed out, killed or are about to be killed
+    bool IsAlive(Entity entity) const;
+
     // Compoment management
     template <typename TComponent, typename... TArgs> void AddComponent(Entity entity, TArgs &&...args);
 
+    // HasComponent() is false right away, the component itself is destroyed and
+    // the entity leaves the systems that required it in the next Update()
     template <typename TComponent> void RemoveComponent(Entity entity);
     template <typename TComponent> bool HasComponent(Entity entity) const;
     template <typename TComponent> TComponent &GetComponent(Entity entity) const;
 
+    // Returns the pool of a component type, creating it if needed
+    template <typename TComponent> Pool<TComponent> *GetOrCreatePool();
+    // Preallocates room in a single pool for the entity ids below maxEntities.
+    // Pools are indexed by entity id, so this has to cover the highest id that
+    // will get the component, not the number of entities that have it
+    template <typename TComponent> void ReserveComponents(size_t maxEntities);
+
     // System management
     template <typename TSystem, typename... TArgs> void AddSystem(TArgs &&...args);
     template <typename TSystem> void RemoveSystem();
@@ -182,29 +382,38 @@ class Registry
     // Checks the component signature of an entity and add the entity to the
     // systems that are interested in it
     void AddEntityToSystem(Entity entity);
+    void RemoveEntityFromSystems(Entity entity);
+
+    // Statistics for debugging tools
+    int GetNumEntities() const;
+    size_t GetNumComponentTypes() const;
+    ComponentPoolStats GetComponentPoolStats(size_t componentId) const;
 
-    // TODO:
-    // CreateEntity()
-    // KillEntity
-    //
-    // AddSystem()
-    // RemoveSystem()
-    // HasSystem()
-    // GetSystem()
-    //
 };
 
 // Implementation of the function template
+template <typename TPredicate> void System::RemoveEntitiesFromSystem(TPredicate shouldRemove)
+{
+    entities.erase(std::remove_if(entities.begin(), entities.end(), shouldRemove), entities.end());
+}
+
 template <typename TComponent> void System::RequireComponent()
 {
     const auto componentId = Component<TComponent>::GetId();
     componentSignature.set(componentId);
 }
 
+template <typename TComponent> Pool<TComponent> &System::GetPool() const
+{
+    return *registry->GetOrCreatePool<TComponent>();
+}
+
 template <typename TSystem, typename... TArgs> void Registry::AddSystem(TArgs &&...args)
 {
-    std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
-    systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+    ALLOCATION_SCOPE(ALLOC_ECS);
+    std::unique_ptr<System> newSystem = std::make_unique<TSystem>(std::forward<TArgs>(args)...);
+    newSystem->registry = this;
+    systems.insert(std::make_pair(std::type_index(typeid(TSystem)), std::move(newSystem)));
 }
 
 template <typename TSystem> void Registry::RemoveSystem()
@@ -221,59 +430,116 @@ template <typename TSystem> bool Registry::HasSystem() const
 template <typename TSystem> TSystem &Registry::GetSystem() const
 {
     auto system = systems.find(std::type_index(typeid(TSystem)));
-    return *(std::static_pointer_cast<TSystem>(system->second));
+    return *static_cast<TSystem *>(system->second.get());
 }
 
-template <typename TComponent, typename... TArgs> void Registry::AddComponent(Entity entity, TArgs &&...args)
+template <typename TComponent> Pool<TComponent> *Registry::GetOrCreatePool()
 {
     const auto componentId = Component<TComponent>::GetId();
-    const auto entityId = entity.GetId();
 
     // if componentId not already in componentPools, increase the size
     // of the componentPools.
     if (componentId >= componentPools.size())
     {
-        componentPools.resize(componentId + 1, nullptr);
+        componentPools.resize(componentId + 1);
+        componentNames.resize(componentId + 1, nullptr);
+        componentCounts.resize(componentId + 1, 0);
     }
 
     // If there is no pointer to a componentPool already at componentId index
     // then create a new componentPool
     if (!componentPools[componentId])
     {
-        std::shared_ptr<Pool<TComponent>> newComponentPool = std::make_shared<Pool<TComponent>>();
-        componentPools[componentId] = newComponentPool;
+        auto newComponentPool = std::make_unique<Pool<TComponent>>();
+        newComponentPool->Reserve(reservedEntities);
+        componentPools[componentId] = std::move(newComponentPool);
+        componentNames[componentId] = typeid(TComponent).name();
     }
 
-    // pointer to componentPool of componentId
-    std::shared_ptr<Pool<TComponent>> componentPool =
-        std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+    return static_cast<Pool<TComponent> *>(componentPools[componentId].get());
+}
 
-    // ensure that we have space for the entityId in componentPool
-    if (entityId >= componentPool->GetSize())
+template <typename TComponent> void Registry::ReserveComponents(size_t maxEntities)
+{
+    ALLOCATION_SCOPE(ALLOC_ECS);
+    GetOrCreatePool<TComponent>()->Reserve(maxEntities);
+}
+
+template <typename... TComponents, typename TInitializer>
+Entity Registry::CreateEntities(size_t count, const Prefab<TComponents...> &prefab, TInitializer initialize)
+{
+    ALLOCATION_SCOPE(ALLOC_ECS);
+
+    // Bulk created entities always get fresh ids so they are contiguous in the pools
+    const int firstId = numEntities;
+    numEntities += static_cast<int>(count);
+    entityComponentSignatures.resize(numEntities, prefab.GetSignature());
+    entityFlags.resize(numEntities, 0);
+
+    // Grow every pool once and copy the prefab's components into the new slots
+    [[maybe_unused]] auto pools = std::make_tuple(GetOrCreatePool<TComponents>()...);
+    (std::get<Pool<TComponents> *>(pools)->Fill(firstId, static_cast<int>(count),
+                                                 std::get<TComponents>(prefab.GetComponents())),
+     ...);
+    ((componentCounts[Component<TComponents>::GetId()] += count), ...);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        initialize(i, std::get<Pool<TComponents> *>(pools)->Get(firstId + static_cast<int>(i))...);
+    }
+
+    // The systems pick the whole batch up in the next Update()
+    entitiesToBeAdded.reserve(entitiesToBeAdded.size() + count);
+    for (size_t i = 0; i < count; i++)
     {
-        componentPool->Resize(numEntities);
+        Entity entity(firstId + static_cast<int>(i));
+        entity.registry = this;
+        entitiesToBeAdded.push_back(entity);
     }
 
-    // create new Component of propert type
-    TComponent newComponent(std::forward<TArgs>(args)...);
+    LOGGER_LOG("{} entities created with ids {} to {}", count, firstId, numEntities - 1);
 
-    //
-    componentPool->Set(entityId, newComponent);
+    Entity first(firstId);
+    first.registry = this;
+    return first;
+}
 
+template <typename... TComponents> Entity Registry::CreateEntities(size_t count, const Prefab<TComponents...> &prefab)
+{
+    return CreateEntities(count, prefab, [](size_t, TComponents &...) {});
+}
+
+template <typename TComponent, typename... TArgs> void Registry::AddComponent(Entity entity, TArgs &&...args)
+{
+    ALLOCATION_SCOPE(ALLOC_ECS);
+    const auto componentId = Component<TComponent>::GetId();
+    const auto entityId = entity.GetId();
+
+    // Construct the component straight into the pool's storage, the pool grows
+    // geometrically if the entity id does not fit yet
+    GetOrCreatePool<TComponent>()->Emplace(entityId, std::forward<TArgs>(args)...);
+
+    if (!entityComponentSignatures[entityId].test(componentId))
+    {
+        componentCounts[componentId]++;
+    }
     entityComponentSignatures[entityId].set(componentId);
 
-    Logger::Log("Component Id = " + std::to_string(componentId) + " was added to entity id " +
-                std::to_string(entityId));
+    LOGGER_LOG("Component Id = {} was added to entity id {}", componentId, entityId);
 }
 
 template <typename TComponent> void Registry::RemoveComponent(Entity entity)
 {
     const auto componentId = Component<TComponent>::GetId();
     const auto entityId = entity.GetId();
+    if (entityComponentSignatures[entityId].test(componentId))
+    {
+        componentCounts[componentId]--;
+        componentsToBeRemoved.push_back({entityId, componentId});
+    }
     entityComponentSignatures[entityId].set(componentId, false);
 
-    Logger::Log("Component Id = " + std::to_string(componentId) + " was removed from entity id " +
-                std::to_string(entityId));
+    LOGGER_LOG("Component Id = {} was removed from entity id {}", componentId, entityId);
 }
 
 template <typename TComponent> bool Registry::HasComponent(Entity entity) const
@@ -287,8 +553,7 @@ template <typename TComponent> TComponent &Registry::GetComponent(Entity entity)
 {
     const auto componentId = Component<TComponent>::GetId();
     const auto entityId = entity.GetId();
-    auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-    return componentPool->Get(entityId);
+    return static_cast<Pool<TComponent> *>(componentPools[componentId].get())->Get(entityId);
 }
 
 template <typename TComponent, typename... TArgs> void Entity::AddComponent(TArgs &&...args)
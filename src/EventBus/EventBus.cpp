@@ -0,0 +1,67 @@
+#include "EventBus.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
+
+int IEvent::nextId = 0;
+
+void EventBus::Dispatch()
+{
+    PROFILE_SCOPE("EventBus::Dispatch");
+
+    if (isDispatching)
+    {
+        LOGGER_WARN("EventBus::Dispatch called from an event handler, the events wait for the next dispatch");
+        return;
+    }
+    isDispatching = true;
+
+    // Take every queue's events before the first handler runs, so all events
+    // emitted by handlers end up in the next dispatch and not just some of them
+    dispatchedCount = 0;
+    for (auto &queue : queues)
+    {
+        if (queue)
+        {
+            dispatchedCount += queue->TakeQueued();
+        }
+    }
+    if (dispatchedCount > 0)
+    {
+        // By index, a handler that uses a new event type adds a queue
+        for (size_t eventId = 0; eventId < queues.size(); eventId++)
+        {
+            if (queues[eventId])
+            {
+                queues[eventId]->DeliverTaken();
+            }
+        }
+    }
+
+    isDispatching = false;
+}
+
+void EventBus::Clear()
+{
+    for (auto &queue : queues)
+    {
+        if (queue)
+        {
+            queue->Clear();
+        }
+    }
+}
+
+size_t EventBus::GetQueuedCount() const
+{
+    size_t count = 0;
+    for (const auto &queue : queues)
+    {
+        if (queue)
+        {
+            count += queue->GetQueuedCount();
+        }
+    }
+    return count;
+}
+
+size_t EventBus::GetDispatchedCount() const { return dispatchedCount; }
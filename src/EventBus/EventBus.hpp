@@ -0,0 +1,263 @@
+#pragma once
+
+#include "../Memory/AllocationTracker.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct IEvent
+{
+  protected:
+    static int nextId;
+};
+
+// Used to assign a unique id to an event type, like Component<T> does for components
+template <typename T> class Event : public IEvent
+{
+  public:
+    // Returns the unique id of Event<T>
+    static int GetId()
+    {
+        static auto id = nextId++;
+        return id;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// EventHandler
+//////////////////////////////////////////////////////////////////////////////////
+// A subscriber is an instance pointer plus a thunk: a plain function generated
+// for the handler method that casts the pointers back and calls the method on
+// a whole batch of events. Delivering a batch costs one indirect call per
+// subscriber, the method call inside the loop is direct and can be inlined
+//////////////////////////////////////////////////////////////////////////////////
+struct EventHandler
+{
+    using Thunk = void (*)(void *instance, const void *events, size_t count);
+
+    Thunk thunk;
+    void *instance;
+
+    bool operator==(const EventHandler &other) const { return thunk == other.thunk && instance == other.instance; }
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// EventQueue
+//////////////////////////////////////////////////////////////////////////////////
+// The subscribers of one event type and the events of that type waiting for
+// the next dispatch, stored by value in a contiguous buffer. The buffers keep
+// their capacity, after the first few frames emitting does not allocate.
+// A dispatch takes the queued events out first, so events emitted by the
+// handlers go into the other buffer and wait for the next dispatch
+//////////////////////////////////////////////////////////////////////////////////
+class IEventQueue
+{
+  public:
+    virtual ~IEventQueue() = default;
+    // Moves the queued events aside for DeliverTaken(), returns how many there are
+    virtual size_t TakeQueued() = 0;
+    virtual void DeliverTaken() = 0;
+    virtual void Clear() = 0;
+    virtual size_t GetQueuedCount() const = 0;
+};
+
+template <typename TEvent> class EventQueue : public IEventQueue
+{
+  private:
+    std::vector<EventHandler> handlers;
+    std::vector<TEvent> queued;
+    std::vector<TEvent> taken;
+    // Handlers of this type are running. Unsubscribing meanwhile only clears
+    // the thunk, the entry is removed once they are done
+    int deliveryDepth = 0;
+    bool hasRemovedHandlers = false;
+
+    void RemoveClearedHandlers()
+    {
+        handlers.erase(std::remove_if(handlers.begin(), handlers.end(),
+                                      [](const EventHandler &handler) { return handler.thunk == nullptr; }),
+                       handlers.end());
+        hasRemovedHandlers = false;
+    }
+
+  public:
+    void Subscribe(const EventHandler &handler) { handlers.push_back(handler); }
+
+    void Unsubscribe(const EventHandler &handler)
+    {
+        for (auto &subscribed : handlers)
+        {
+            if (subscribed == handler)
+            {
+                subscribed.thunk = nullptr;
+                hasRemovedHandlers = true;
+            }
+        }
+        if (deliveryDepth == 0 && hasRemovedHandlers)
+        {
+            RemoveClearedHandlers();
+        }
+    }
+
+    bool HasSubscribers() const { return !handlers.empty(); }
+
+    template <typename... TArgs> void Emit(TArgs &&...args) { queued.push_back(TEvent{std::forward<TArgs>(args)...}); }
+
+    // Calls every handler with the batch. Handlers subscribed meanwhile get the
+    // events from the next batch on
+    void Deliver(const TEvent *events, size_t count)
+    {
+        deliveryDepth++;
+        const auto handlerCount = handlers.size();
+        for (size_t i = 0; i < handlerCount; i++)
+        {
+            // A copy, a handler that subscribes may reallocate the vector
+            const auto handler = handlers[i];
+            if (handler.thunk)
+            {
+                handler.thunk(handler.instance, events, count);
+            }
+        }
+        deliveryDepth--;
+        if (deliveryDepth == 0 && hasRemovedHandlers)
+        {
+            RemoveClearedHandlers();
+        }
+    }
+
+    size_t TakeQueued() override
+    {
+        taken.swap(queued);
+        return taken.size();
+    }
+
+    void DeliverTaken() override
+    {
+        if (!taken.empty())
+        {
+            Deliver(taken.data(), taken.size());
+            taken.clear();
+        }
+    }
+
+    void Clear() override { queued.clear(); }
+    size_t GetQueuedCount() const override { return queued.size(); }
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// EventBus
+//////////////////////////////////////////////////////////////////////////////////
+// Typed events between systems (collisions, damage, input). A handler is a
+// method that takes either one event or a whole batch:
+//
+//     void OnCollision(const CollisionEvent &event);
+//     void OnCollisions(const CollisionEvent *events, size_t count);
+//
+//     eventBus.Subscribe<CollisionEvent, &ScriptSystem::OnCollisions>(this);
+//     eventBus.Emit<CollisionEvent>(first, second);      // deferred
+//     eventBus.EmitNow(CollisionEvent{first, second});   // immediate
+//
+// Deferred events are queued per type and delivered by Dispatch(), one batch
+// per type and subscriber. Immediate events skip the queue and the handlers
+// run inside EmitNow(). Neither allocates per event, there is no std::function
+// and no type erasure of the events themselves.
+// Subscribers have to unsubscribe before they are destroyed
+//////////////////////////////////////////////////////////////////////////////////
+class EventBus
+{
+  private:
+    // Indexed by Event<T>::GetId(), a type gets its queue when first used
+    std::vector<std::unique_ptr<IEventQueue>> queues;
+    bool isDispatching = false;
+    size_t dispatchedCount = 0;
+
+    template <typename TEvent> EventQueue<TEvent> &GetQueue()
+    {
+        const auto eventId = Event<TEvent>::GetId();
+        if (static_cast<size_t>(eventId) >= queues.size())
+        {
+            queues.resize(eventId + 1);
+        }
+        if (!queues[eventId])
+        {
+            queues[eventId] = std::make_unique<EventQueue<TEvent>>();
+        }
+        return static_cast<EventQueue<TEvent> &>(*queues[eventId]);
+    }
+
+    template <typename TEvent> const EventQueue<TEvent> *FindQueue() const
+    {
+        const auto eventId = Event<TEvent>::GetId();
+        if (static_cast<size_t>(eventId) >= queues.size() || !queues[eventId])
+        {
+            return nullptr;
+        }
+        return static_cast<const EventQueue<TEvent> *>(queues[eventId].get());
+    }
+
+    template <typename TEvent, auto Method, typename TOwner>
+    static void Invoke(void *instance, const void *events, size_t count)
+    {
+        auto *owner = static_cast<TOwner *>(instance);
+        const auto *typedEvents = static_cast<const TEvent *>(events);
+        if constexpr (std::is_invocable_v<decltype(Method), TOwner *, const TEvent *, size_t>)
+        {
+            (owner->*Method)(typedEvents, count);
+        }
+        else
+        {
+            static_assert(std::is_invocable_v<decltype(Method), TOwner *, const TEvent &>,
+                          "An event handler takes (const TEvent &) or (const TEvent *, size_t)");
+            for (size_t i = 0; i < count; i++)
+            {
+                (owner->*Method)(typedEvents[i]);
+            }
+        }
+    }
+
+    template <typename TEvent, auto Method, typename TOwner> static EventHandler MakeHandler(TOwner *owner)
+    {
+        return {&Invoke<TEvent, Method, TOwner>, owner};
+    }
+
+  public:
+    template <typename TEvent, auto Method, typename TOwner> void Subscribe(TOwner *owner)
+    {
+        GetQueue<TEvent>().Subscribe(MakeHandler<TEvent, Method>(owner));
+    }
+
+    template <typename TEvent, auto Method, typename TOwner> void Unsubscribe(TOwner *owner)
+    {
+        GetQueue<TEvent>().Unsubscribe(MakeHandler<TEvent, Method>(owner));
+    }
+
+    // Lets emitters skip building events nobody listens to
+    template <typename TEvent> bool HasSubscribers() const
+    {
+        const auto *queue = FindQueue<TEvent>();
+        return queue && queue->HasSubscribers();
+    }
+
+    // Queues an event constructed from args until the next Dispatch()
+    template <typename TEvent, typename... TArgs> void Emit(TArgs &&...args)
+    {
+        ALLOCATION_SCOPE(ALLOC_EVENTS);
+        GetQueue<TEvent>().Emit(std::forward<TArgs>(args)...);
+    }
+
+    // Calls the handlers of the event before returning
+    template <typename TEvent> void EmitNow(const TEvent &event) { GetQueue<TEvent>().Deliver(&event, 1); }
+
+    // Delivers every queued event, one batch per type in the order of the event
+    // ids. Events emitted by the handlers wait for the next call
+    void Dispatch();
+    // Drops the queued events without delivering them
+    void Clear();
+
+    size_t GetQueuedCount() const;
+    // Events delivered by the last Dispatch()
+    size_t GetDispatchedCount() const;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+// Emitted by the CollisionSystem for two entities whose box colliders overlap,
+// every tick for as long as they do
+struct CollisionEvent
+{
+    int first;
+    int second;
+};
@@ -0,0 +1,98 @@
+#include "FileWatcher.hpp"
+#include "../Logger/Logger.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+FileWatcher::FileWatcher()
+{
+    fileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fileDescriptor < 0)
+    {
+        LOGGER_ERR("Failed to initialize inotify: {}", std::strerror(errno));
+    }
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (fileDescriptor >= 0)
+    {
+        close(fileDescriptor);
+    }
+}
+
+bool FileWatcher::IsSupported() const { return fileDescriptor >= 0; }
+
+bool FileWatcher::AddDirectory(const std::string &directory)
+{
+    if (fileDescriptor < 0)
+    {
+        return false;
+    }
+    // Editors either write the file in place or write a temporary file and
+    // rename it over the original, so look for both
+    const auto watch = inotify_add_watch(fileDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0)
+    {
+        LOGGER_ERR("Failed to watch {}: {}", directory, std::strerror(errno));
+        return false;
+    }
+    directories[watch] = directory;
+    return true;
+}
+
+void FileWatcher::Poll(std::vector<std::string> &changedFiles)
+{
+    if (fileDescriptor < 0)
+    {
+        return;
+    }
+
+    const auto firstNew = changedFiles.size();
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        const auto length = read(fileDescriptor, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            // EAGAIN, nothing more to read
+            break;
+        }
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const auto event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            const auto directory = directories.find(event->wd);
+            if (event->len == 0 || directory == directories.end())
+            {
+                continue;
+            }
+            auto path = directory->second + "/" + event->name;
+            if (std::find(changedFiles.begin() + firstNew, changedFiles.end(), path) == changedFiles.end())
+            {
+                changedFiles.push_back(std::move(path));
+            }
+        }
+    }
+}
+
+#else
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {}
+
+bool FileWatcher::IsSupported() const { return false; }
+
+bool FileWatcher::AddDirectory(const std::string &) { return false; }
+
+void FileWatcher::Poll(std::vector<std::string> &) {}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////
+// FileWatcher
+//////////////////////////////////////////////////////////////////////////////////
+// Reports files that were written in a set of directories, used to hot reload
+// assets and scripts. Poll() never blocks, so it can be called every frame.
+// The reported paths are the watched directory joined with the file name, e.g.
+// watching "./assets/images" reports "./assets/images/tree.png", so they match
+// the paths the assets were loaded with as long as both are written the same
+// way. Only implemented with inotify on Linux, elsewhere nothing is reported
+//////////////////////////////////////////////////////////////////////////////////
+class FileWatcher
+{
+  private:
+    int fileDescriptor = -1;
+    // Watch descriptor -> directory
+    std::unordered_map<int, std::string> directories;
+
+  public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    bool IsSupported() const;
+
+    // Not recursive, returns false if the directory can't be watched
+    bool AddDirectory(const std::string &directory);
+
+    // Appends the files changed since the last call, every path at most once
+    void Poll(std::vector<std::string> &changedFiles);
+};
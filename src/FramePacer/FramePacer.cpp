@@ -0,0 +1,106 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+FramePacer::FramePacer(int targetRate, size_t historySize) : frameTimes(historySize)
+{
+    SetTargetRate(targetRate);
+    Reset();
+}
+
+void FramePacer::SetTargetRate(int targetRate)
+{
+    if (targetRate > 0)
+    {
+        targetFrameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetRate));
+    }
+    else
+    {
+        targetFrameTime = Clock::duration::zero();
+    }
+}
+
+void FramePacer::Reset()
+{
+    previousFrame = Clock::now();
+    nextDeadline = previousFrame + targetFrameTime;
+}
+
+double FramePacer::WaitForNextFrame()
+{
+    if (targetFrameTime > Clock::duration::zero())
+    {
+        auto now = Clock::now();
+        if (nextDeadline - now > FRAME_PACER_SPIN_THRESHOLD)
+        {
+            std::this_thread::sleep_for(nextDeadline - now - FRAME_PACER_SPIN_THRESHOLD);
+        }
+        while (Clock::now() < nextDeadline)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    const auto now = Clock::now();
+    const auto frameTime = std::chrono::duration<double>(now - previousFrame).count();
+    previousFrame = now;
+
+    // Schedule against the previous deadline so the rate does not drift, but
+    // don't try to make up for frames that were more than a frame late
+    nextDeadline += targetFrameTime;
+    if (nextDeadline < now)
+    {
+        nextDeadline = now + targetFrameTime;
+    }
+
+    if (!frameTimes.empty())
+    {
+        frameTimes[nextSample] = static_cast<float>(frameTime * 1000.0);
+        nextSample = (nextSample + 1) % frameTimes.size();
+        sampleCount = std::min(sampleCount + 1, frameTimes.size());
+    }
+
+    return frameTime;
+}
+
+std::chrono::nanoseconds FramePacer::GetTimeUntilNextFrame() const
+{
+    const auto remaining = nextDeadline - Clock::now();
+    return std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining), std::chrono::nanoseconds::zero());
+}
+
+FrameTimeStats FramePacer::GetStats() const
+{
+    FrameTimeStats stats;
+    auto samples = GetFrameTimes();
+    if (samples.empty())
+    {
+        return stats;
+    }
+
+    stats.samples = samples.size();
+    for (auto sample : samples)
+    {
+        stats.average += sample;
+    }
+    stats.average /= samples.size();
+
+    std::sort(samples.begin(), samples.end());
+    stats.p50 = samples[(samples.size() - 1) * 50 / 100];
+    stats.p99 = samples[(samples.size() - 1) * 99 / 100];
+    stats.max = samples.back();
+    return stats;
+}
+
+std::vector<float> FramePacer::GetFrameTimes() const
+{
+    std::vector<float> result;
+    result.reserve(sampleCount);
+    const auto first = (nextSample + frameTimes.size() - sampleCount) % std::max<size_t>(frameTimes.size(), 1);
+    for (size_t i = 0; i < sampleCount; i++)
+    {
+        result.push_back(frameTimes[(first + i) % frameTimes.size()]);
+    }
+    return result;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// Number of frame times kept for the statistics
+const size_t FRAME_TIME_HISTORY_SIZE = 1024;
+
+// Below this much remaining time the pacer stops sleeping and spins, since the
+// OS scheduler can oversleep by a millisecond or more
+const std::chrono::microseconds FRAME_PACER_SPIN_THRESHOLD(2000);
+
+struct FrameTimeStats
+{
+    size_t samples = 0;
+    double average = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// FramePacer
+//////////////////////////////////////////////////////////////////////////////////
+// Keeps frames at a target rate using the high resolution steady clock. It
+// sleeps for most of the remaining frame time and spins for the last part so
+// frames start on time, and records the frame times (in milliseconds) for
+// statistics
+//////////////////////////////////////////////////////////////////////////////////
+class FramePacer
+{
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    // Zero means no limit
+    Clock::duration targetFrameTime;
+    Clock::time_point previousFrame;
+    Clock::time_point nextDeadline;
+
+    std::vector<float> frameTimes;
+    size_t nextSample = 0;
+    size_t sampleCount = 0;
+
+  public:
+    FramePacer(int targetRate = 60, size_t historySize = FRAME_TIME_HISTORY_SIZE);
+
+    // Frames per second to aim for, 0 disables pacing
+    void SetTargetRate(int targetRate);
+
+    // Restarts the frame clock, e.g. after loading a level
+    void Reset();
+
+    // Waits until the next frame is due and returns the seconds since the previous frame started
+    double WaitForNextFrame();
+
+    // Time left until the next frame is due, zero if it is already late
+    std::chrono::nanoseconds GetTimeUntilNextFrame() const;
+
+    FrameTimeStats GetStats() const;
+
+    // Recorded frame times in milliseconds, oldest first
+    std::vector<float> GetFrameTimes() const;
+};
@@ -1,37 +1,67 @@
 #include "Game.hpp"
 #include "../AssetStore/AssetStore.hpp"
 #include "../Components/AnimationComponent.hpp"
+#include "../Components/BoxColliderComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
 #include "../Components/SpriteComponent.hpp"
 #include "../Components/TranformComponent.hpp"
 #include "../ECS/ECS.hpp"
+#include "../LevelLoader/LevelLoader.hpp"
 #include "../Logger/Logger.hpp"
+#include "../Memory/AllocationTracker.hpp"
+#include "../Profiler/Profiler.hpp"
 #include "../Systems/AnimationSystem.hpp"
+#include "../Systems/CollisionSystem.hpp"
 #include "../Systems/MovementSystem.hpp"
 #include "../Systems/RenderSystem.hpp"
+#include "../Systems/ScriptSystem.hpp"
+#include "../Systems/SpatialSystem.hpp"
 #include <SDL.h>
 #include <SDL_image.h>
-#include <fstream>
+#include <chrono>
+#include <cmath>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <map>
-#include <sstream>
+#include <random>
 
-Game::Game()
+Game::Game() : framePacer(FPS)
 {
-    Logger::Log("Game constructor called!");
+    LOGGER_LOG("Game constructor called!");
     registry = std::make_unique<Registry>();
     assetStore = std::make_unique<AssetStore>();
     isRunning = false;
 }
 
-Game::~Game() { Logger::Err("Game destructor called!"); }
+Game::~Game() { LOGGER_ERR("Game destructor called!"); }
 
 void Game::Initialize()
 {
+    if (checkAllocations && !AllocationTracker::IsEnabled())
+    {
+        LOGGER_ERR("The allocation check needs a build with TRACK_ALLOCATIONS=1");
+        allocationCheckFailed = true;
+        return;
+    }
+
+    if (isHeadless)
+    {
+        // Only what the simulation needs, no video or audio
+        if (SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS) != 0)
+        {
+            LOGGER_ERR("Error initializing SDL: {}", SDL_GetError());
+            return;
+        }
+        windowWidth = 800;
+        windowHeight = 480;
+        framePacer.SetTargetRate(0);
+        isRunning = true;
+        return;
+    }
+
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
     {
-        Logger::Err("Error initializing SDL.");
+        LOGGER_ERR("Error initializing SDL: {}", SDL_GetError());
         return;
     }
     SDL_DisplayMode displayMode;
@@ -42,182 +72,458 @@ void Game::Initialize()
                               SDL_WINDOW_BORDERLESS);
     if (!window)
     {
-        Logger::Err("Error creating SDL window.");
+        LOGGER_ERR("Error creating SDL window: {}", SDL_GetError());
         return;
     }
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    // Frames are paced either by vsync or by the frame pacer, never by both
+    Uint32 rendererFlags = SDL_RENDERER_ACCELERATED;
+    if (isVsyncEnabled)
+    {
+        rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+        framePacer.SetTargetRate(0);
+    }
+    renderer = SDL_CreateRenderer(window, -1, rendererFlags);
     if (!renderer)
     {
-        Logger::Err("Error creating SDL Renderer.");
+        LOGGER_ERR("Error creating SDL Renderer: {}", SDL_GetError());
         return;
     }
 
     // SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN);
 
+    debugOverlay.Initialize(renderer, windowWidth, windowHeight);
+
     isRunning = true;
 }
 
 void Game::ProcessInput()
 {
-    SDL_Event sdlEvent;
-    while (SDL_PollEvent(&sdlEvent))
+    PROFILE_FUNCTION();
+
+    input.Poll();
+    const auto &actions = input.GetFrameActions();
+    if (input.IsQuitRequested() || actions.WasPressed(ACTION_QUIT))
     {
-        switch (sdlEvent.type)
-        {
-        case SDL_QUIT:
-            isRunning = false;
-            break;
-        case SDL_KEYDOWN:
-            if ((sdlEvent.key.keysym.sym == SDLK_ESCAPE) || (sdlEvent.key.keysym.sym == SDLK_q))
-            {
-                isRunning = false;
-            }
-            break;
-        }
+        isRunning = false;
     }
+    if (actions.WasPressed(ACTION_TOGGLE_OVERLAY))
+    {
+        debugOverlay.Toggle();
+    }
+    debugOverlay.ProcessInput(input);
 }
 
 void Game::LoadLevel(int level)
 {
+    PROFILE_FUNCTION();
+
     // Add the systems that need to be processed in our game
     registry->AddSystem<MovementSystem>();
     registry->AddSystem<RenderSystem>();
     registry->AddSystem<AnimationSystem>();
+    registry->AddSystem<CollisionSystem>();
+    registry->AddSystem<SpatialSystem>();
+    // Registers its Lua functions, so it has to exist before the level script runs
+    auto &lua = scriptRuntime.GetState();
+    registry->AddSystem<ScriptSystem>(lua, eventBus, input);
+
+    // The level script adds the assets and spawns the entities
+    lua["window_width"] = windowWidth;
+    lua["window_height"] = windowHeight;
+    if (!LevelLoader::LoadLevel(lua, level, *registry, assetStore, renderer))
+    {
+        LOGGER_ERR("Level {} could not be loaded", level);
+    }
+}
 
-    // Adding assets to the Asset Store
-    assetStore->AddTexture(renderer, "tank-image", "./assets/images/tank-panther-right.png");
-    assetStore->AddTexture(renderer, "truck-image", "./assets/images/truck-ford-right.png");
-    assetStore->AddTexture(renderer, "chopper-image", "./assets/images/chopper.png");
-    assetStore->AddTexture(renderer, "radar-image", "./assets/images/radar.png");
-
-    // Load the tilemap
-    assetStore->AddTexture(renderer, "tilemap", "./assets/tilemaps/jungle.png");
+void Game::Setup()
+{
+    if (!replayPath.empty())
+    {
+        if (!replayPlayer.Open(replayPath))
+        {
+            hasReplayFailed = true;
+            isRunning = false;
+            return;
+        }
+        // The simulation starts the way the recording did and stops where it stopped
+        const auto &header = replayPlayer.GetHeader();
+        startLevel = static_cast<int>(header.level);
+        SetTickRate(static_cast<int>(header.ticksPerSecond));
+        SetRandomSeed(header.randomSeed);
+        maxTicks = replayPlayer.GetTickCount();
+        // A max tick count of 0 would run forever instead of replaying nothing
+        if (maxTicks == 0)
+        {
+            LOGGER_ERR("The replay file {} has no recorded ticks", replayPath);
+            hasReplayFailed = true;
+            isRunning = false;
+            return;
+        }
+        isReplaying = true;
+        LOGGER_LOG("Replaying {}: level {}, {} ticks at {} ticks/s", replayPath, startLevel, maxTicks, ticksPerSecond);
+    }
+    if (!hasRandomSeed)
+    {
+        std::random_device device;
+        randomSeed = (static_cast<uint64_t>(device()) << 32) | device();
+        LOGGER_LOG("Random seed {}, use --seed {} to repeat the run", randomSeed, randomSeed);
+    }
 
-    // define some variables for tilemap processing
-    auto tileSize = 32;
-    auto tileScale = 2.0;
-    auto spritesInPNGRow = 10;
+    auto &lua = scriptRuntime.GetState();
+    lua.open_libraries(sol::lib::base, sol::lib::math, sol::lib::string, sol::lib::table, sol::lib::io,
+                       sol::lib::coroutine);
+    lua["math"]["randomseed"](static_cast<lua_Integer>(randomSeed));
+    LoadLevel(startLevel);
 
-    // Read in the contents of jungle.map
-    std::ifstream mapfile("./assets/tilemaps/jungle.map");
-    std::string line;
-    auto y = 0;
+    if (!recordPath.empty())
+    {
+        const ReplayHeader header = {static_cast<uint32_t>(startLevel), static_cast<uint32_t>(ticksPerSecond),
+                                     randomSeed, 0};
+        if (!replayRecorder.Open(recordPath, header))
+        {
+            hasReplayFailed = true;
+            isRunning = false;
+            return;
+        }
+        LOGGER_LOG("Recording to {}", recordPath);
+    }
 
-    // read lines from map file until EOF
-    while (std::getline(mapfile, line))
+    // Nothing is edited during headless runs, and a reload would make the
+    // simulation differ from the recording
+    if (isHotReloadEnabled && !isHeadless && recordPath.empty() && !isReplaying)
     {
+        for (const auto *directory : {"./assets/images", "./assets/tilemaps", "./assets/scripts",
+                                      "./assets/scripts/behaviors"})
+        {
+            fileWatcher.AddDirectory(directory);
+        }
+    }
 
-        // create string stream from read in line
-        std::stringstream s(line);
+    // Don't count the level loading as frame time
+    framePacer.Reset();
+}
 
-        std::string word;
-        auto x = 0;
+void Game::ReloadChangedFiles()
+{
+    changedFiles.clear();
+    fileWatcher.Poll(changedFiles);
+    if (changedFiles.empty())
+    {
+        return;
+    }
+    PROFILE_FUNCTION();
 
-        // break line into words that contain the tilenumber
-        while (std::getline(s, word, ','))
+    for (const auto &path : changedFiles)
+    {
+        // The same file may be a texture and be watched by a script
+        const auto start = std::chrono::steady_clock::now();
+        auto reloaded = assetStore->ReloadTextures(renderer, path);
+        reloaded |= registry->GetSystem<ScriptSystem>().OnFileChanged(path);
+        if (reloaded)
         {
-            // get tile number as integer
-            auto tilenum = std::stoi(word);
+            const auto milliseconds =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            LOGGER_LOG("Reloaded {} in {} ms", path, milliseconds);
+        }
+    }
+}
 
-            // create a new tile entity
-            Entity tile = registry->CreateEntity();
+void Game::Update()
+{
+    PROFILE_FUNCTION();
 
-            // derive the position in the map
-            auto xpos = x * tileSize * tileScale;
-            auto ypos = y * tileSize * tileScale;
+    // if we are too fast, wait until the next frame is due. Returns the time
+    // since the previous frame in seconds
+    {
+        PROFILE_SCOPE("FramePacer::WaitForNextFrame");
+        frameTime = framePacer.WaitForNextFrame();
+    }
 
-            // derive the offset in the tilemap
-            auto xoffset = (tilenum % spritesInPNGRow) * tileSize;
-            auto yoffset = (tilenum / spritesInPNGRow) * tileSize;
+    // Sample the input after the wait and right before the ticks, sampling it
+    // before the wait would add up to a frame of latency
+    ProcessInput();
 
-            // place the tile and associate the proper tile sprite
-            tile.AddComponent<TransformComponent>(glm::vec2(xpos, ypos), glm::vec2(tileScale, tileScale), 0.0);
-            tile.AddComponent<SpriteComponent>("tilemap", tileSize, tileSize, 0, xoffset, yoffset);
+    // Headless runs advance exactly one tick per frame, independent of how fast
+    // the machine is
+    if (isHeadless)
+    {
+        frameTime = fixedDeltaTime;
+    }
 
-            x++;
-        }
+    // Run as many fixed simulation steps as fit into the time that has passed,
+    // the remainder is carried over to the next frame
+    accumulator += frameTime;
+    auto steps = 0;
+    while (isRunning && accumulator >= fixedDeltaTime && steps < maxStepsPerFrame)
+    {
+        FixedUpdate(fixedDeltaTime);
+        accumulator -= fixedDeltaTime;
+        steps++;
+    }
+    if (accumulator >= fixedDeltaTime)
+    {
+        // We can't keep up, let the simulation fall behind wall clock time
+        accumulator = std::fmod(accumulator, fixedDeltaTime);
+    }
+    interpolationAlpha = accumulator / fixedDeltaTime;
+
+    // Animations are purely visual and follow wall clock time
+    registry->GetSystem<AnimationSystem>().Update();
+}
 
-        y++;
+void Game::FixedUpdate(double deltaTime)
+{
+    PROFILE_FUNCTION();
+
+    // The presses and releases since the previous tick
+    input.BeginTick();
+    if (isReplaying)
+    {
+        input.SetTickActions(replayPlayer.GetActions(tickCount));
     }
+    replayRecorder.RecordActions(tickCount, input.GetTickActions());
 
-    // done with the map file
-    mapfile.close();
+    // Ask all the systems to update, scripts first so the velocities they set
+    // are applied in the same tick
+    registry->GetSystem<ScriptSystem>().Update(deltaTime);
+    registry->GetSystem<MovementSystem>().Update(deltaTime);
+    registry->GetSystem<CollisionSystem>().Update(eventBus);
+
+    // The handlers may kill entities, the registry update below removes them
+    eventBus.Dispatch();
+
+    // Update the registry to process the entities that are waiting to be
+    // created/deleted
+    registry->Update();
+    // After the registry update, so the tree holds the entities created during the tick
+    registry->GetSystem<SpatialSystem>().Update();
+
+    tickCount++;
+
+    if (tickCount % REPLAY_CHECKSUM_INTERVAL == 0 && (isReplaying || replayRecorder.IsOpen()))
+    {
+        const auto checksum = ComputeSimulationChecksum();
+        replayRecorder.RecordChecksum(tickCount, checksum);
+        // Only the first mismatch is interesting, everything after it differs as well
+        if (isReplaying && !replayPlayer.CheckChecksum(tickCount, checksum) &&
+            replayPlayer.GetDivergedTick() == tickCount)
+        {
+            LOGGER_ERR("The replay diverged from the recording at tick {}", tickCount);
+        }
+    }
 
-    // Create some entity
-    Entity chopper = registry->CreateEntity();
-    chopper.AddComponent<TransformComponent>(glm::vec2(10.0, 100.0), glm::vec2(1.0, 1.0), 0.0);
-    chopper.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
-    chopper.AddComponent<SpriteComponent>("chopper-image", 32, 32, 1);
-    chopper.AddComponent<AnimationComponent>(2, 15, true);
+    if (maxTicks > 0 && tickCount >= maxTicks)
+    {
+        isRunning = false;
+    }
+}
 
-    Entity radar = registry->CreateEntity();
-    radar.AddComponent<TransformComponent>(glm::vec2(windowWidth - 74, 10.0), glm::vec2(1.0, 1.0), 0.0);
-    radar.AddComponent<RigidBodyComponent>(glm::vec2(0.0, 0.0));
-    radar.AddComponent<SpriteComponent>("radar-image", 64, 64, 2);
-    radar.AddComponent<AnimationComponent>(8, 5, true);
+uint64_t Game::ComputeSimulationChecksum()
+{
+    PROFILE_FUNCTION();
 
-    Entity tank = registry->CreateEntity();
-    tank.AddComponent<TransformComponent>(glm::vec2(10.0, 10.0), glm::vec2(1.0, 1.0), 0.0);
-    tank.AddComponent<RigidBodyComponent>(glm::vec2(30.0, 0.0));
-    tank.AddComponent<SpriteComponent>("tank-image", 32, 32, 1);
+    // FNV-1a over the raw bytes, a bit identical simulation gives the same hash
+    uint64_t hash = 14695981039346656037ull;
+    const auto add = [&hash](const void *data, size_t size)
+    {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
 
-    Entity truck = registry->CreateEntity();
-    truck.AddComponent<TransformComponent>(glm::vec2(10.0, 50.0), glm::vec2(1.0, 1.0), 0.0);
-    truck.AddComponent<RigidBodyComponent>(glm::vec2(20.0, 0.0));
-    truck.AddComponent<SpriteComponent>("truck-image", 32, 32, 2);
+    const auto numEntities = registry->GetNumEntities();
+    add(&numEntities, sizeof(numEntities));
+    const auto *transforms = registry->GetOrCreatePool<TransformComponent>();
+    const auto *rigidBodies = registry->GetOrCreatePool<RigidBodyComponent>();
+    for (int id = 0; id < static_cast<int>(transforms->GetSize()); id++)
+    {
+        if (!transforms->Has(id))
+        {
+            continue;
+        }
+        const auto &transform = transforms->Get(id);
+        add(&id, sizeof(id));
+        add(&transform.position, sizeof(transform.position));
+        add(&transform.rotation, sizeof(transform.rotation));
+        if (rigidBodies->Has(id))
+        {
+            add(&rigidBodies->Get(id).velocity, sizeof(glm::vec2));
+        }
+    }
+    return hash;
 }
 
-void Game::Setup() { LoadLevel(1); }
+void Game::SetAllocationCheck(bool enabled) { checkAllocations = enabled; }
 
-void Game::Update()
+bool Game::HasAllocationCheckFailed() const { return allocationCheckFailed; }
+
+void Game::CheckFrameAllocations()
 {
-    // if we are too fast, waste some time until we reach the MILLISECS_PER_FRAME
-    int timeToWait = MILLISECS_PER_FRAME - (SDL_GetTicks() - millisecsPreviousFrame);
-    if (timeToWait > 0 && timeToWait <= MILLISECS_PER_FRAME)
+    if (frameCount <= ALLOCATION_CHECK_WARMUP_FRAMES || AllocationTracker::GetLastFrameAllocations() == 0)
     {
-        SDL_Delay(timeToWait);
+        return;
     }
 
-    // The difference in ticks since the last frame, converted to seconds
-    double deltaTime = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
+    LOGGER_ERR("Frame {} allocated memory after the warmup, all threads by tag:", frameCount);
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++)
+    {
+        const auto counters = AllocationTracker::GetLastFrame(static_cast<AllocationTag>(tag));
+        if (counters.allocations > 0)
+        {
+            LOGGER_ERR("  {}: {} allocations, {} bytes", AllocationTracker::GetTagName(static_cast<AllocationTag>(tag)),
+                       counters.allocations, counters.bytes);
+        }
+    }
+    allocationCheckFailed = true;
+    isRunning = false;
+}
 
-    // Store the current frame time
-    millisecsPreviousFrame = SDL_GetTicks();
+void Game::SetHeadless(bool headless) { isHeadless = headless; }
 
-    // Ask all the systems to update
-    registry->GetSystem<MovementSystem>().Update(deltaTime);
-    registry->GetSystem<AnimationSystem>().Update();
+void Game::SetVsync(bool enabled) { isVsyncEnabled = enabled; }
 
-    // Update the registry to process the entities that are waiting to be
-    // created/deleted
-    registry->Update();
+void Game::SetMaxTicks(unsigned long long ticks) { maxTicks = ticks; }
+
+void Game::SetTargetFrameRate(int framesPerSecond) { framePacer.SetTargetRate(framesPerSecond); }
+
+void Game::SetTickRate(int ticksPerSecond)
+{
+    this->ticksPerSecond = ticksPerSecond;
+    fixedDeltaTime = 1.0 / ticksPerSecond;
+}
+
+void Game::SetMaxStepsPerFrame(int maxSteps) { maxStepsPerFrame = maxSteps; }
+
+void Game::SetStartLevel(int level) { startLevel = level; }
+
+void Game::SetHotReload(bool enabled) { isHotReloadEnabled = enabled; }
+
+void Game::SetRandomSeed(uint64_t seed)
+{
+    randomSeed = seed;
+    hasRandomSeed = true;
 }
 
+void Game::SetRecordPath(const std::string &path) { recordPath = path; }
+
+void Game::SetReplayPath(const std::string &path) { replayPath = path; }
+
+bool Game::HasReplayFailed() const { return hasReplayFailed || replayPlayer.HasDiverged(); }
+
+bool Game::SetScriptGcMode(ScriptGcMode mode) { return scriptRuntime.SetGcMode(mode); }
+
+void Game::SetScriptGcBudget(std::chrono::nanoseconds budget) { scriptRuntime.SetGcBudget(budget); }
+
+unsigned long long Game::GetTickCount() const { return tickCount; }
+
 void Game::Render()
 {
+    if (!renderer)
+    {
+        return;
+    }
+    PROFILE_FUNCTION();
+
     SDL_SetRenderDrawColor(renderer, 21, 21, 21, 255);
     SDL_RenderClear(renderer);
 
     // Invoke all the systems that need to render
-    registry->GetSystem<RenderSystem>().Update(renderer, assetStore);
+    registry->GetSystem<RenderSystem>().Update(renderer, assetStore, interpolationAlpha, frameArena.GetCurrent());
+
+    // Drawn last so it is on top, does nothing while hidden
+    debugOverlay.Render(frameTime, *registry, *assetStore, framePacer, frameArena, scriptRuntime,
+                        registry->GetSystem<RenderSystem>().GetDrawCallCount());
 
+    PROFILE_SCOPE("SDL_RenderPresent");
     SDL_RenderPresent(renderer);
 }
 
 void Game::Run()
 {
     Setup();
+
+    const auto start = std::chrono::steady_clock::now();
     while (isRunning)
     {
-        ProcessInput();
-        Update();
-        Render();
+        PROFILE_BEGIN_FRAME();
+        AllocationTracker::BeginFrame();
+        {
+            PROFILE_SCOPE("Frame");
+            ALLOCATION_SCOPE(ALLOC_GAME);
+            ReloadChangedFiles();
+            Update();
+            Render();
+
+            // The frame is on screen, spend the time until the next one collecting Lua garbage
+            scriptRuntime.CollectGarbage(framePacer.GetTimeUntilNextFrame());
+
+            // Everything allocated from the arena two frames ago is released
+            frameArena.EndFrame();
+        }
+        AllocationTracker::EndFrame();
+        PROFILE_END_FRAME();
+
+        frameCount++;
+        if (checkAllocations)
+        {
+            CheckFrameAllocations();
+        }
+    }
+
+    if (isHeadless)
+    {
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LOGGER_LOG("Headless run finished: {} ticks in {} s ({} ticks/s)", tickCount, seconds, tickCount / seconds);
     }
 }
 
 void Game::Destroy()
 {
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
+    const auto stats = framePacer.GetStats();
+    LOGGER_LOG("Frame time over the last {} frames: avg = {} ms, p50 = {} ms, p99 = {} ms, max = {} ms",
+               stats.samples, stats.average, stats.p50, stats.p99, stats.max);
+    const auto scriptMemory = scriptRuntime.GetMemoryStats();
+    LOGGER_LOG("Lua memory: {} bytes, {} collector cycles, {} forced full collections", scriptMemory.luaBytes,
+               scriptMemory.completedCycles, scriptMemory.emergencyCollections);
+    const auto inputLatency = input.GetLatencyStats();
+    if (inputLatency.samples > 0)
+    {
+        LOGGER_LOG("Input latency, worst case from the previous poll to the tick, over the last {} inputs: "
+                   "avg = {} ms, max = {} ms",
+                   inputLatency.samples, inputLatency.average, inputLatency.max);
+    }
+    if (replayRecorder.IsOpen())
+    {
+        replayRecorder.Close(tickCount);
+        LOGGER_LOG("Recorded {} ticks to {}", tickCount, recordPath);
+    }
+    if (isReplaying)
+    {
+        if (replayPlayer.HasDiverged())
+        {
+            LOGGER_ERR("Replay of {} diverged at tick {}", replayPath, replayPlayer.GetDivergedTick());
+        }
+        else
+        {
+            LOGGER_LOG("Replay of {} matched the recording: {} ticks, {} checksums", replayPath, tickCount,
+                       replayPlayer.GetCheckedCount());
+        }
+    }
+    PROFILE_WRITE_TRACE("trace.json");
+
+    debugOverlay.Destroy();
+    input.Destroy();
+
+    if (renderer)
+    {
+        SDL_DestroyRenderer(renderer);
+    }
+    if (window)
+    {
+        SDL_DestroyWindow(window);
+    }
     SDL_Quit();
 }
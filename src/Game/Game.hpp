@@ -1,23 +1,99 @@
 #pragma once
 
 #include "../AssetStore/AssetStore.hpp"
+#include "../DebugOverlay/DebugOverlay.hpp"
 #include "../ECS/ECS.hpp"
+#include "../EventBus/EventBus.hpp"
+#include "../FileWatcher/FileWatcher.hpp"
+#include "../FramePacer/FramePacer.hpp"
+#include "../Input/Input.hpp"
+#include "../Memory/FrameArena.hpp"
+#include "../Replay/Replay.hpp"
+#include "../ScriptRuntime/ScriptRuntime.hpp"
 #include <SDL.h>
 
 const int FPS = 60;
-const int MILLISECS_PER_FRAME = 1000 / FPS;
+
+// Default rate of the fixed simulation step
+const int TICKS_PER_SECOND = 60;
+// Upper bound of simulation steps per frame, a slow frame drops the rest of its
+// backlog instead of making the next frame even slower
+const int MAX_STEPS_PER_FRAME = 5;
+
+// Frames that may allocate before the allocation check expects a steady state
+const int ALLOCATION_CHECK_WARMUP_FRAMES = 60;
 
 class Game
 {
   private:
     bool isRunning;
-    int millisecsPreviousFrame = 0;
-    SDL_Window *window;
-    SDL_Renderer *renderer;
+    // Run without a window and renderer, one simulation tick per frame as fast as possible
+    bool isHeadless = false;
+    // Let the display's vsync pace the frames instead of the frame pacer
+    bool isVsyncEnabled = false;
+    // Stop after this many simulation ticks, 0 runs until quit
+    unsigned long long maxTicks = 0;
+    FramePacer framePacer;
+    // Wall clock duration of the last frame in seconds
+    double frameTime = 0.0;
+    DebugOverlay debugOverlay;
+
+    // Scratch memory for data that only lives for a frame (or into the next one)
+    FrameArena frameArena;
+
+    // Fixed timestep state, all in seconds
+    double fixedDeltaTime = 1.0 / TICKS_PER_SECOND;
+    int maxStepsPerFrame = MAX_STEPS_PER_FRAME;
+    double accumulator = 0.0;
+    // How far the rendered frame is between the last two ticks (0..1)
+    double interpolationAlpha = 0.0;
+    unsigned long long tickCount = 0;
+    unsigned long long frameCount = 0;
+
+    // Fail the run if a frame after the warmup allocates (needs TRACK_ALLOCATIONS=1)
+    bool checkAllocations = false;
+    bool allocationCheckFailed = false;
+    void CheckFrameAllocations();
+
+    SDL_Window *window = nullptr;
+    SDL_Renderer *renderer = nullptr;
+
+    // Runs the level and behavior scripts. Declared before the registry so it
+    // is destroyed after the systems that hold references into it
+    ScriptRuntime scriptRuntime;
+    // Level loaded by Setup()
+    int startLevel = 1;
+
+    // Events between the systems, dispatched once per tick. Declared before the
+    // registry as well, the systems unsubscribe when they are destroyed
+    EventBus eventBus;
+    // Polled once per frame right before the fixed update, the scripts read the actions
+    Input input;
 
     std::unique_ptr<Registry> registry;
     std::unique_ptr<AssetStore> assetStore;
 
+    // Seeds math.random, a random one is picked by Setup() unless one was given
+    uint64_t randomSeed = 0;
+    bool hasRandomSeed = false;
+    int ticksPerSecond = TICKS_PER_SECOND;
+
+    // Records the actions of every tick, or plays them back instead of the input
+    std::string recordPath;
+    std::string replayPath;
+    ReplayRecorder replayRecorder;
+    ReplayPlayer replayPlayer;
+    bool isReplaying = false;
+    bool hasReplayFailed = false;
+    // Hash of the entity positions and velocities, compared between recording and replay
+    uint64_t ComputeSimulationChecksum();
+
+    // Reloads changed textures, tilemaps and scripts while the game runs
+    bool isHotReloadEnabled = true;
+    FileWatcher fileWatcher;
+    std::vector<std::string> changedFiles;
+    void ReloadChangedFiles();
+
   public:
     Game();
     ~Game();
@@ -27,9 +103,30 @@ class Game
     void LoadLevel(int level);
     void ProcessInput();
     void Update();
+    void FixedUpdate(double deltaTime);
     void Render();
     void Destroy();
 
+    void SetHeadless(bool headless);
+    void SetVsync(bool enabled);
+    void SetMaxTicks(unsigned long long ticks);
+    void SetAllocationCheck(bool enabled);
+    bool HasAllocationCheckFailed() const;
+    void SetTargetFrameRate(int framesPerSecond);
+    void SetTickRate(int ticksPerSecond);
+    void SetMaxStepsPerFrame(int maxSteps);
+    void SetStartLevel(int level);
+    void SetHotReload(bool enabled);
+    void SetRandomSeed(uint64_t seed);
+    void SetRecordPath(const std::string &path);
+    void SetReplayPath(const std::string &path);
+    // The replay could not be loaded or the simulation did not match the recording
+    bool HasReplayFailed() const;
+    // Returns false if the mode is not available with this Lua version
+    bool SetScriptGcMode(ScriptGcMode mode);
+    void SetScriptGcBudget(std::chrono::nanoseconds budget);
+    unsigned long long GetTickCount() const;
+
     int windowWidth;
     int windowHeight;
 };
@@ -0,0 +1,281 @@
+#include "Input.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
+
+#include <algorithm>
+
+static const char *const ACTION_NAMES[ACTION_COUNT] = {"quit",      "toggle_overlay", "move_up", "move_down",
+                                                       "move_left", "move_right",     "fire"};
+
+Input::Input() : latencies(INPUT_LATENCY_HISTORY_SIZE) { BindDefaults(); }
+
+void Input::BindDefaults()
+{
+    ClearBindings();
+    BindKey(ACTION_QUIT, SDL_SCANCODE_ESCAPE);
+    BindKey(ACTION_QUIT, SDL_SCANCODE_Q);
+    BindKey(ACTION_TOGGLE_OVERLAY, SDL_SCANCODE_F1);
+
+    BindKey(ACTION_MOVE_UP, SDL_SCANCODE_W);
+    BindKey(ACTION_MOVE_UP, SDL_SCANCODE_UP);
+    BindControllerAxis(ACTION_MOVE_UP, SDL_CONTROLLER_AXIS_LEFTY, -1);
+    BindKey(ACTION_MOVE_DOWN, SDL_SCANCODE_S);
+    BindKey(ACTION_MOVE_DOWN, SDL_SCANCODE_DOWN);
+    BindControllerAxis(ACTION_MOVE_DOWN, SDL_CONTROLLER_AXIS_LEFTY, 1);
+    BindKey(ACTION_MOVE_LEFT, SDL_SCANCODE_A);
+    BindKey(ACTION_MOVE_LEFT, SDL_SCANCODE_LEFT);
+    BindControllerAxis(ACTION_MOVE_LEFT, SDL_CONTROLLER_AXIS_LEFTX, -1);
+    BindKey(ACTION_MOVE_RIGHT, SDL_SCANCODE_D);
+    BindKey(ACTION_MOVE_RIGHT, SDL_SCANCODE_RIGHT);
+    BindControllerAxis(ACTION_MOVE_RIGHT, SDL_CONTROLLER_AXIS_LEFTX, 1);
+
+    BindKey(ACTION_FIRE, SDL_SCANCODE_SPACE);
+    BindMouseButton(ACTION_FIRE, SDL_BUTTON_LEFT);
+    BindControllerButton(ACTION_FIRE, SDL_CONTROLLER_BUTTON_A);
+}
+
+void Input::ClearBindings() { bindings.clear(); }
+
+void Input::BindKey(InputAction action, SDL_Scancode scancode)
+{
+    bindings.push_back({action, BINDING_KEY, scancode, 0});
+}
+
+void Input::BindMouseButton(InputAction action, int button)
+{
+    bindings.push_back({action, BINDING_MOUSE_BUTTON, button, 0});
+}
+
+void Input::BindControllerButton(InputAction action, int button)
+{
+    bindings.push_back({action, BINDING_CONTROLLER_BUTTON, button, 0});
+}
+
+void Input::BindControllerAxis(InputAction action, int axis, int direction)
+{
+    bindings.push_back({action, BINDING_CONTROLLER_AXIS, axis, direction});
+}
+
+ActionMask Input::ResolveActions() const
+{
+    ActionMask actions = 0;
+    for (const auto &binding : bindings)
+    {
+        bool isDown = false;
+        switch (binding.type)
+        {
+        case BINDING_KEY:
+            isDown = state.keys[binding.code];
+            break;
+        case BINDING_MOUSE_BUTTON:
+            isDown = state.mouseButtons & SDL_BUTTON(binding.code);
+            break;
+        case BINDING_CONTROLLER_BUTTON:
+            isDown = (state.controllerButtons >> binding.code) & 1;
+            break;
+        case BINDING_CONTROLLER_AXIS:
+            isDown = state.controllerAxes[binding.code] * binding.direction > INPUT_AXIS_THRESHOLD;
+            break;
+        }
+        if (isDown)
+        {
+            actions |= 1u << binding.action;
+        }
+    }
+    return actions;
+}
+
+void Input::OpenController(int deviceIndex)
+{
+    if (!SDL_IsGameController(deviceIndex) || controllers.size() >= INPUT_MAX_CONTROLLERS)
+    {
+        return;
+    }
+    auto *controller = SDL_GameControllerOpen(deviceIndex);
+    if (!controller)
+    {
+        LOGGER_WARN("Could not open controller {}: {}", deviceIndex, SDL_GetError());
+        return;
+    }
+    controllers.push_back(controller);
+    const char *name = SDL_GameControllerName(controller);
+    LOGGER_LOG("Controller connected: {}", name ? name : "unknown controller");
+}
+
+void Input::CloseController(SDL_JoystickID instanceId)
+{
+    for (size_t i = 0; i < controllers.size(); i++)
+    {
+        if (SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(controllers[i])) == instanceId)
+        {
+            SDL_GameControllerClose(controllers[i]);
+            controllers.erase(controllers.begin() + i);
+            // Nothing stays held when the controller is gone
+            state.controllerButtons = 0;
+            std::fill(std::begin(state.controllerAxes), std::end(state.controllerAxes), 0.0f);
+            return;
+        }
+    }
+}
+
+void Input::OnEvent(const SDL_Event &event)
+{
+    switch (event.type)
+    {
+    case SDL_QUIT:
+        isQuitRequested = true;
+        return;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        if (event.key.repeat)
+        {
+            return;
+        }
+        state.keys[event.key.keysym.scancode] = event.type == SDL_KEYDOWN;
+        break;
+    case SDL_MOUSEMOTION:
+        state.mouseX = event.motion.x;
+        state.mouseY = event.motion.y;
+        // Moving the mouse does not change any action
+        return;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        state.mouseX = event.button.x;
+        state.mouseY = event.button.y;
+        if (event.type == SDL_MOUSEBUTTONDOWN)
+        {
+            state.mouseButtons |= SDL_BUTTON(event.button.button);
+        }
+        else
+        {
+            state.mouseButtons &= ~SDL_BUTTON(event.button.button);
+        }
+        break;
+    case SDL_MOUSEWHEEL:
+        state.mouseWheel += static_cast<float>(event.wheel.y);
+        return;
+    case SDL_CONTROLLERDEVICEADDED:
+        OpenController(event.cdevice.which);
+        return;
+    case SDL_CONTROLLERDEVICEREMOVED:
+        CloseController(event.cdevice.which);
+        break;
+    case SDL_CONTROLLERBUTTONDOWN:
+        state.controllerButtons |= 1u << event.cbutton.button;
+        break;
+    case SDL_CONTROLLERBUTTONUP:
+        state.controllerButtons &= ~(1u << event.cbutton.button);
+        break;
+    case SDL_CONTROLLERAXISMOTION:
+        state.controllerAxes[event.caxis.axis] = std::max(-1.0f, event.caxis.value / 32767.0f);
+        break;
+    default:
+        return;
+    }
+
+    // Latch the edges, a press and release between two ticks still reaches the next one
+    const auto actions = ResolveActions();
+    const auto pressed = actions & ~down;
+    const auto released = down & ~actions;
+    if ((pressed | released) == 0)
+    {
+        return;
+    }
+    tickPressed |= pressed;
+    tickReleased |= released;
+    frameActions.pressed |= pressed;
+    frameActions.released |= released;
+    down = actions;
+    if (!hasPendingEdge)
+    {
+        oldestPendingEdge = previousPoll;
+        hasPendingEdge = true;
+    }
+}
+
+void Input::Poll()
+{
+    PROFILE_FUNCTION();
+
+    const auto now = std::chrono::steady_clock::now();
+    if (previousPoll == std::chrono::steady_clock::time_point())
+    {
+        previousPoll = now;
+    }
+    state.mouseWheel = 0.0f;
+    frameActions.pressed = 0;
+    frameActions.released = 0;
+
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+        OnEvent(event);
+    }
+    frameActions.down = down;
+    previousPoll = now;
+}
+
+void Input::BeginTick()
+{
+    tickActions.down = down;
+    tickActions.pressed = tickPressed;
+    tickActions.released = tickReleased;
+    tickPressed = 0;
+    tickReleased = 0;
+
+    if (hasPendingEdge)
+    {
+        latencies[nextLatency] =
+            std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - oldestPendingEdge).count();
+        nextLatency = (nextLatency + 1) % latencies.size();
+        latencyCount = std::min(latencyCount + 1, latencies.size());
+        hasPendingEdge = false;
+    }
+}
+
+void Input::SetTickActions(const ActionState &actions) { tickActions = actions; }
+
+void Input::Destroy()
+{
+    for (auto *controller : controllers)
+    {
+        SDL_GameControllerClose(controller);
+    }
+    controllers.clear();
+}
+
+const InputState &Input::GetState() const { return state; }
+
+const ActionState &Input::GetTickActions() const { return tickActions; }
+
+const ActionState &Input::GetFrameActions() const { return frameActions; }
+
+bool Input::IsQuitRequested() const { return isQuitRequested; }
+
+InputLatencyStats Input::GetLatencyStats() const
+{
+    InputLatencyStats stats;
+    stats.samples = latencyCount;
+    for (size_t i = 0; i < latencyCount; i++)
+    {
+        stats.average += latencies[i];
+        stats.max = std::max(stats.max, static_cast<double>(latencies[i]));
+    }
+    if (latencyCount > 0)
+    {
+        stats.average /= latencyCount;
+    }
+    return stats;
+}
+
+InputAction Input::FindAction(const std::string &name)
+{
+    for (int action = 0; action < ACTION_COUNT; action++)
+    {
+        if (name == ACTION_NAMES[action])
+        {
+            return static_cast<InputAction>(action);
+        }
+    }
+    return ACTION_COUNT;
+}
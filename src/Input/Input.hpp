@@ -0,0 +1,172 @@
+#pragma once
+
+#include <SDL.h>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Things the player can do, bound to keys, mouse buttons and controller inputs
+enum InputAction
+{
+    ACTION_QUIT,
+    ACTION_TOGGLE_OVERLAY,
+    ACTION_MOVE_UP,
+    ACTION_MOVE_DOWN,
+    ACTION_MOVE_LEFT,
+    ACTION_MOVE_RIGHT,
+    ACTION_FIRE,
+    ACTION_COUNT
+};
+
+// One bit per InputAction
+typedef uint32_t ActionMask;
+
+// A controller axis past this fraction of its range counts as pressed
+const float INPUT_AXIS_THRESHOLD = 0.5f;
+const int INPUT_MAX_CONTROLLERS = 4;
+// Latency samples kept for the statistics
+const size_t INPUT_LATENCY_HISTORY_SIZE = 256;
+
+// The devices as of the last Poll()
+struct InputState
+{
+    // Indexed by SDL_Scancode
+    std::bitset<SDL_NUM_SCANCODES> keys;
+    // SDL_BUTTON() bits
+    uint32_t mouseButtons = 0;
+    int mouseX = 0;
+    int mouseY = 0;
+    // Wheel movement during the last Poll()
+    float mouseWheel = 0.0f;
+    // All controllers share one state, SDL_GameControllerButton bits
+    uint32_t controllerButtons = 0;
+    // SDL_GameControllerAxis values in -1..1
+    float controllerAxes[SDL_CONTROLLER_AXIS_MAX] = {};
+};
+
+// The actions as seen by one simulation tick, or by one frame. A press is
+// reported by exactly one tick even if the key was released again before the
+// tick ran, or if the frame ran several ticks
+struct ActionState
+{
+    ActionMask down = 0;
+    ActionMask pressed = 0;
+    ActionMask released = 0;
+
+    bool IsDown(InputAction action) const { return (down >> action) & 1; }
+    bool WasPressed(InputAction action) const { return (pressed >> action) & 1; }
+    bool WasReleased(InputAction action) const { return (released >> action) & 1; }
+};
+
+// Milliseconds from the Poll() before the one that saw a press or release to
+// the tick that handed it to the simulation. The input happened somewhere in
+// between, so this is the longest it can have waited: a frame, plus whatever
+// runs between the Poll() and the tick (the frame pacer's wait, if it polled
+// before the wait). SDL's event timestamps can't be used for this, SDL sets
+// them when Poll() pumps the events and not when the OS received them
+struct InputLatencyStats
+{
+    size_t samples = 0;
+    double average = 0.0;
+    double max = 0.0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// Input
+//////////////////////////////////////////////////////////////////////////////////
+// Drains the SDL event queue once per frame into an InputState and maps it to
+// actions through bindings. The game polls right before the fixed update, after
+// the frame pacer's wait, so input is as fresh as possible when the ticks run.
+// Queries are bit tests on the ActionMasks, no lookups by name or key:
+//
+//     if (input.GetTickActions().WasPressed(ACTION_FIRE)) { ... }
+//
+// Edges are latched between ticks: BeginTick() hands the presses and releases
+// since the previous tick to the tick that is about to run
+//////////////////////////////////////////////////////////////////////////////////
+class Input
+{
+  private:
+    enum BindingType
+    {
+        BINDING_KEY,
+        BINDING_MOUSE_BUTTON,
+        BINDING_CONTROLLER_BUTTON,
+        // Code is the axis, direction -1 or 1 which end of it
+        BINDING_CONTROLLER_AXIS
+    };
+
+    struct Binding
+    {
+        InputAction action;
+        BindingType type;
+        int code;
+        int direction;
+    };
+
+    InputState state;
+    std::vector<Binding> bindings;
+    std::vector<SDL_GameController *> controllers;
+    bool isQuitRequested = false;
+
+    // Actions down after the last event that was processed
+    ActionMask down = 0;
+    // Edges since the last tick, and during the last Poll()
+    ActionMask tickPressed = 0;
+    ActionMask tickReleased = 0;
+    ActionState tickActions;
+    ActionState frameActions;
+
+    // Start of the previous Poll(), the events of the current one arrived after it
+    std::chrono::steady_clock::time_point previousPoll;
+    // Earliest the oldest edge no tick has seen yet can have happened
+    std::chrono::steady_clock::time_point oldestPendingEdge;
+    bool hasPendingEdge = false;
+    std::vector<float> latencies;
+    size_t nextLatency = 0;
+    size_t latencyCount = 0;
+
+    ActionMask ResolveActions() const;
+    void OnEvent(const SDL_Event &event);
+    void OpenController(int deviceIndex);
+    void CloseController(SDL_JoystickID instanceId);
+
+  public:
+    Input();
+
+    Input(const Input &) = delete;
+    Input &operator=(const Input &) = delete;
+
+    // Escape/Q quit, F1 toggles the overlay, WASD/arrows/left stick move,
+    // space/left mouse button/controller A fire
+    void BindDefaults();
+    void ClearBindings();
+    void BindKey(InputAction action, SDL_Scancode scancode);
+    void BindMouseButton(InputAction action, int button);
+    void BindControllerButton(InputAction action, int button);
+    void BindControllerAxis(InputAction action, int axis, int direction);
+
+    // Processes the pending SDL events, call once per frame
+    void Poll();
+    // Takes the edges latched since the previous tick, call at the start of every tick
+    void BeginTick();
+    // Replaces what BeginTick() took with recorded actions, for replays
+    void SetTickActions(const ActionState &actions);
+    // Closes the controllers, before SDL_Quit()
+    void Destroy();
+
+    const InputState &GetState() const;
+    // For the simulation, only valid during a tick
+    const ActionState &GetTickActions() const;
+    // For everything that runs once per frame (quitting, debug keys)
+    const ActionState &GetFrameActions() const;
+    // The window was closed
+    bool IsQuitRequested() const;
+
+    InputLatencyStats GetLatencyStats() const;
+
+    // "move_up" -> ACTION_MOVE_UP, ACTION_COUNT if there is no such action
+    static InputAction FindAction(const std::string &name);
+};
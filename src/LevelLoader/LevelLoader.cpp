@@ -0,0 +1,252 @@
+#include "LevelLoader.hpp"
+#include "../Components/AnimationComponent.hpp"
+#include "../Components/BoxColliderComponent.hpp"
+#include "../Components/RigidBodyComponent.hpp"
+#include "../Components/ScriptComponent.hpp"
+#include "../Components/SpriteComponent.hpp"
+#include "../Components/TranformComponent.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// The components of an entity definition, empty if the table does not have them
+struct EntityDefinition
+{
+    std::optional<TransformComponent> transform;
+    std::optional<RigidBodyComponent> rigidbody;
+    std::optional<SpriteComponent> sprite;
+    std::optional<AnimationComponent> animation;
+    std::optional<ScriptComponent> script;
+    std::optional<BoxColliderComponent> boxCollider;
+};
+
+// Per-entity values of spawn_prefab(), two floats per entity or empty
+struct InstanceArrays
+{
+    std::vector<float> positions;
+    std::vector<float> velocities;
+    std::vector<float> srcRects;
+};
+
+static glm::vec2 ReadVec2(const sol::table &table, const char *key, glm::vec2 fallback)
+{
+    sol::optional<sol::table> vector = table[key];
+    if (!vector)
+    {
+        return fallback;
+    }
+    return glm::vec2(vector->get_or("x", fallback.x), vector->get_or("y", fallback.y));
+}
+
+static EntityDefinition ReadDefinition(const sol::table &components)
+{
+    EntityDefinition definition;
+
+    sol::optional<sol::table> transform = components["transform"];
+    if (transform)
+    {
+        definition.transform.emplace(ReadVec2(*transform, "position", glm::vec2(0, 0)),
+                                     ReadVec2(*transform, "scale", glm::vec2(1, 1)),
+                                     transform->get_or("rotation", 0.0));
+    }
+
+    sol::optional<sol::table> rigidbody = components["rigidbody"];
+    if (rigidbody)
+    {
+        definition.rigidbody.emplace(ReadVec2(*rigidbody, "velocity", glm::vec2(0, 0)));
+    }
+
+    sol::optional<sol::table> sprite = components["sprite"];
+    if (sprite)
+    {
+        const auto srcRect = ReadVec2(*sprite, "src_rect", glm::vec2(0, 0));
+        definition.sprite.emplace(sprite->get_or<std::string>("texture_asset_id", ""), sprite->get_or("width", 0),
+                                  sprite->get_or("height", 0), sprite->get_or("z_index", 0),
+                                  static_cast<int>(srcRect.x), static_cast<int>(srcRect.y));
+    }
+
+    sol::optional<sol::table> animation = components["animation"];
+    if (animation)
+    {
+        definition.animation.emplace(animation->get_or("num_frames", 1), animation->get_or("speed_rate", 1),
+                                     animation->get_or("is_loop", true));
+    }
+
+    sol::optional<sol::table> script = components["script"];
+    if (script)
+    {
+        definition.script.emplace(script->get_or<std::string>("behavior", ""));
+    }
+
+    sol::optional<sol::table> boxCollider = components["box_collider"];
+    if (boxCollider)
+    {
+        definition.boxCollider.emplace(boxCollider->get_or("width", 0), boxCollider->get_or("height", 0),
+                                       ReadVec2(*boxCollider, "offset", glm::vec2(0, 0)));
+    }
+
+    return definition;
+}
+
+// Copies instances[key] into a vector, empty if the key is missing
+static std::vector<float> ReadArray(const sol::table &instances, const char *key)
+{
+    std::vector<float> values;
+    sol::optional<sol::table> array = instances[key];
+    if (array)
+    {
+        values.resize(array->size());
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            values[i] = array->raw_get<float>(i + 1);
+        }
+    }
+    return values;
+}
+
+// Overwrite the prefab's values with the ones of instance i, if the level gave any
+static void ApplyInstance(const InstanceArrays &instances, size_t i, TransformComponent &transform)
+{
+    if (!instances.positions.empty())
+    {
+        transform.position = glm::vec2(instances.positions[2 * i], instances.positions[2 * i + 1]);
+        transform.previousPosition = transform.position;
+    }
+}
+
+static void ApplyInstance(const InstanceArrays &instances, size_t i, RigidBodyComponent &rigidbody)
+{
+    if (!instances.velocities.empty())
+    {
+        rigidbody.velocity = glm::vec2(instances.velocities[2 * i], instances.velocities[2 * i + 1]);
+    }
+}
+
+static void ApplyInstance(const InstanceArrays &instances, size_t i, SpriteComponent &sprite)
+{
+    if (!instances.srcRects.empty())
+    {
+        sprite.srcRect.x = static_cast<int>(instances.srcRects[2 * i]);
+        sprite.srcRect.y = static_cast<int>(instances.srcRects[2 * i + 1]);
+    }
+}
+
+static void ApplyInstance(const InstanceArrays &, size_t, AnimationComponent &) {}
+
+static void ApplyInstance(const InstanceArrays &, size_t, ScriptComponent &) {}
+
+static void ApplyInstance(const InstanceArrays &, size_t, BoxColliderComponent &) {}
+
+// The components of a definition are only known at runtime, these overloads
+// walk the optional components and collect the present ones in a tuple so the
+// matching Prefab type is picked at compile time, one instantiation for each
+// combination of components
+template <typename... TPresent>
+static Entity SpawnEntities(Registry &registry, size_t count, const InstanceArrays &instances,
+                            std::tuple<TPresent...> present)
+{
+    auto prefab = std::make_from_tuple<Prefab<TPresent...>>(std::move(present));
+    return registry.CreateEntities(
+        count, prefab, [&](size_t i, TPresent &...components) { (ApplyInstance(instances, i, components), ...); });
+}
+
+template <typename... TPresent, typename TNext, typename... TRest>
+static Entity SpawnEntities(Registry &registry, size_t count, const InstanceArrays &instances,
+                            std::tuple<TPresent...> present, const std::optional<TNext> &next,
+                            const std::optional<TRest> &...rest)
+{
+    if (next)
+    {
+        return SpawnEntities(registry, count, instances, std::tuple_cat(std::move(present), std::make_tuple(*next)),
+                             rest...);
+    }
+    return SpawnEntities(registry, count, instances, std::move(present), rest...);
+}
+
+static Entity SpawnEntities(Registry &registry, size_t count, const InstanceArrays &instances,
+                            const EntityDefinition &definition)
+{
+    return SpawnEntities(registry, count, instances, std::tuple<>(), definition.transform, definition.rigidbody,
+                         definition.sprite, definition.animation, definition.script, definition.boxCollider);
+}
+
+bool LevelLoader::LoadLevel(sol::state &lua, int level, Registry &registry, std::unique_ptr<AssetStore> &assetStore,
+                            SDL_Renderer *renderer)
+{
+    PROFILE_FUNCTION();
+
+    // The functions stay registered after loading, so they must not capture
+    // anything that only lives on this stack frame
+    auto *store = assetStore.get();
+    auto *entities = &registry;
+
+    lua.set_function("add_texture", [store, renderer](const std::string &assetId, const std::string &filePath)
+                     { store->AddTexture(renderer, assetId, filePath); });
+
+    lua.set_function("spawn_entities",
+                     [entities](const sol::table &definitions)
+                     {
+                         const auto count = definitions.size();
+                         for (size_t i = 1; i <= count; i++)
+                         {
+                             const auto definition = ReadDefinition(definitions.get<sol::table>(i));
+                             SpawnEntities(*entities, 1, InstanceArrays(), definition);
+                         }
+                         return count;
+                     });
+
+    lua.set_function("spawn_prefab",
+                     [entities](const sol::table &definition, const sol::table &instanceTable)
+                     {
+                         InstanceArrays instances;
+                         instances.positions = ReadArray(instanceTable, "positions");
+                         instances.velocities = ReadArray(instanceTable, "velocities");
+                         instances.srcRects = ReadArray(instanceTable, "src_rects");
+
+                         // Every array holds an x, y pair per entity and they all have to agree
+                         const auto size = std::max({instances.positions.size(), instances.velocities.size(),
+                                                     instances.srcRects.size()});
+                         for (const auto *array : {&instances.positions, &instances.velocities, &instances.srcRects})
+                         {
+                             if (size % 2 != 0 || (!array->empty() && array->size() != size))
+                             {
+                                 LOGGER_ERR("spawn_prefab: the instance arrays need an x, y pair for every entity");
+                                 return std::make_tuple(-1, size_t{0});
+                             }
+                         }
+
+                         const auto first = SpawnEntities(*entities, size / 2, instances, ReadDefinition(definition));
+                         return std::make_tuple(first.GetId(), size / 2);
+                     });
+
+    lua.set_function("kill_entities",
+                     [entities](int first, int count)
+                     {
+                         for (int id = first; id < first + count; id++)
+                         {
+                             // Ranges the script kept around after the entities are gone are ignored
+                             Entity entity(id);
+                             if (entities->IsAlive(entity))
+                             {
+                                 entities->KillEntity(entity);
+                             }
+                         }
+                     });
+
+    const auto scriptPath = "./assets/scripts/Level" + std::to_string(level) + ".lua";
+    sol::protected_function_result result = lua.safe_script_file(scriptPath, sol::script_pass_on_error);
+    if (!result.valid())
+    {
+        sol::error error = result;
+        LOGGER_ERR("Error loading level {} from {}: {}", level, scriptPath, error.what());
+        return false;
+    }
+
+    LOGGER_LOG("Level {} loaded from {}", level, scriptPath);
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../AssetStore/AssetStore.hpp"
+#include "../ECS/ECS.hpp"
+#include <SDL.h>
+#include <memory>
+#include <sol/sol.hpp>
+
+//////////////////////////////////////////////////////////////////////////////////
+// LevelLoader
+//////////////////////////////////////////////////////////////////////////////////
+// Levels are Lua scripts (./assets/scripts/Level<n>.lua) that describe their
+// assets and entities in tables and hand them over with these functions:
+//
+//   add_texture(asset_id, file_path)
+//   spawn_entities({ definition, ... })      -> number of entities created
+//   spawn_prefab(definition, instances)      -> first entity id, number of entities created
+//   kill_entities(first_id, count)
+//
+// A definition is a table of components (transform, rigidbody, sprite,
+// animation, script, box_collider). spawn_prefab() creates one entity per
+// instance from a shared definition, instances holds flat arrays of per-entity
+// values:
+// positions = { x1, y1, x2, y2, ... } and velocities and src_rects in the same
+// layout. Whole arrays cross from Lua to C++ in a single call and the entities
+// are created in bulk with Registry::CreateEntities(), so they have consecutive
+// ids and can be killed again as a range, e.g. to respawn a reloaded tilemap
+//////////////////////////////////////////////////////////////////////////////////
+class LevelLoader
+{
+  public:
+    // Runs the script of the given level, returns false if it failed
+    static bool LoadLevel(sol::state &lua, int level, Registry &registry, std::unique_ptr<AssetStore> &assetStore,
+                          SDL_Renderer *renderer);
+};
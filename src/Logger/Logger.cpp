@@ -1,19 +1,132 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "Logger.hpp"
+#include "../Memory/AllocationTracker.hpp"
 
-#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <termcolor/termcolor.hpp>
+#include <thread>
 
-std::vector<LogEntry> Logger::messages;
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
-std::string CurrentDateTimeToString()
+//////////////////////////////////////////////////////////////////////////////////
+// Ring buffer
+//////////////////////////////////////////////////////////////////////////////////
+// Bounded multi-producer queue of log records. Every cell carries a sequence
+// number telling producers and the consumer whose turn it is, so producers only
+// need a single compare-and-swap to claim a cell and never wait on a lock.
+// There is exactly one consumer at a time, guarded by consumerLock
+//////////////////////////////////////////////////////////////////////////////////
+const size_t LOG_RING_CAPACITY = 8192;
+
+struct LogCell
+{
+    std::atomic<size_t> sequence;
+    LogRecord record;
+};
+
+static LogCell ring[LOG_RING_CAPACITY];
+static std::atomic<size_t> enqueuePosition{0};
+static std::atomic<size_t> dequeuePosition{0};
+static std::atomic<size_t> droppedMessages{0};
+static std::atomic_flag consumerLock = ATOMIC_FLAG_INIT;
+static std::atomic<bool> isRunning{false};
+static std::thread loggingThread;
+
+static bool TryEnqueue(const LogRecord &record)
+{
+    auto position = enqueuePosition.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        auto &cell = ring[position % LOG_RING_CAPACITY];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (diff == 0)
+        {
+            // The cell is free, try to claim it
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.record = record;
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The consumer has not caught up yet, the ring is full
+            return false;
+        }
+        else
+        {
+            // Another producer claimed the cell first
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+static bool TryDequeue(LogRecord &record)
+{
+    const auto position = dequeuePosition.load(std::memory_order_relaxed);
+    auto &cell = ring[position % LOG_RING_CAPACITY];
+    if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+    {
+        return false;
+    }
+    record = cell.record;
+    cell.sequence.store(position + LOG_RING_CAPACITY, std::memory_order_release);
+    dequeuePosition.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////
+// History
+//////////////////////////////////////////////////////////////////////////////////
+// Ring buffer of the newest written entries. Slots are overwritten in place so
+// their strings keep the capacity they already allocated. The buffer is created
+// on first use, so static objects can log while they are constructed
+//////////////////////////////////////////////////////////////////////////////////
+static std::mutex historyMutex;
+static size_t historyNext = 0;
+static size_t historyCount = 0;
+static LogType historyLevel = LOG_INFO;
+
+static std::vector<LogEntry> &GetHistoryBuffer()
 {
-    auto now = std::chrono::system_clock::now();
-    auto currentTime = std::chrono::system_clock::to_time_t(now);
+    static std::vector<LogEntry> history(LOG_HISTORY_DEFAULT_CAPACITY);
+    return history;
+}
+
+static void AddToHistory(LogType type, const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(historyMutex);
+    auto &history = GetHistoryBuffer();
+    if (type < historyLevel || history.empty())
+    {
+        return;
+    }
+    auto &slot = history[historyNext];
+    slot.type = type;
+    slot.message.assign(message);
+    historyNext = (historyNext + 1) % history.size();
+    historyCount = std::min(historyCount + 1, history.size());
+}
+
+static std::string DateTimeToString(std::chrono::system_clock::time_point time)
+{
+    auto currentTime = std::chrono::system_clock::to_time_t(time);
 
     char output[std::size("mm/dd/yyyy hh:mm::ss")];
 
@@ -22,20 +135,261 @@ std::string CurrentDateTimeToString()
     return output;
 }
 
-void Logger::Log(const std::string &message)
+static void WriteRecord(const LogRecord &record)
+{
+    const char *prefix = "LOG: [ ";
+    if (record.type == LOG_WARNING)
+    {
+        prefix = "WRN: [ ";
+    }
+    else if (record.type == LOG_ERROR)
+    {
+        prefix = "ERR: [ ";
+    }
+    std::string message = prefix + DateTimeToString(record.time) + " ]  ";
+    message.append(record.message, record.length);
+
+    switch (record.type)
+    {
+    case LOG_INFO:
+        std::cout << termcolor::green << message << termcolor::reset << '\n';
+        break;
+    case LOG_WARNING:
+        std::cout << termcolor::yellow << message << termcolor::reset << '\n';
+        break;
+    case LOG_ERROR:
+        std::cerr << termcolor::red << message << termcolor::reset << '\n';
+        break;
+    }
+    AddToHistory(record.type, message);
+}
+
+// Writes out everything currently in the ring, returns false if there was nothing to do
+static bool Drain()
+{
+    if (consumerLock.test_and_set(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    LogRecord record;
+    auto count = 0;
+    while (TryDequeue(record))
+    {
+        WriteRecord(record);
+        count++;
+    }
+
+    const auto dropped = droppedMessages.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        std::cerr << termcolor::red << "ERR: " << dropped << " log messages dropped, the log ring buffer was full"
+                  << termcolor::reset << '\n';
+    }
+    if (count > 0 || dropped > 0)
+    {
+        std::cout.flush();
+        std::cerr.flush();
+    }
+
+    consumerLock.clear(std::memory_order_release);
+    return count > 0;
+}
+
+static void LoggingThreadMain()
+{
+    ALLOCATION_SCOPE(ALLOC_LOGGER);
+
+    while (isRunning.load(std::memory_order_acquire))
+    {
+        if (!Drain())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    Drain();
+}
+
+// Writes straight to a file descriptor, unlike iostreams this is safe in a signal handler
+static void WriteRaw(int fileDescriptor, const char *text, size_t length)
+{
+#ifdef _WIN32
+    _write(fileDescriptor, text, static_cast<unsigned int>(length));
+#else
+    while (length > 0)
+    {
+        const auto written = write(fileDescriptor, text, length);
+        if (written <= 0)
+        {
+            return;
+        }
+        text += written;
+        length -= static_cast<size_t>(written);
+    }
+#endif
+}
+
+// Drain() for the crash handler. It only uses async-signal-safe calls, so the
+// records are written without timestamps or colors and are not added to the
+// history, whose mutex the crashing thread may be holding
+static void CrashDrain()
+{
+    if (consumerLock.test_and_set(std::memory_order_acquire))
+    {
+        return;
+    }
+    LogRecord record;
+    while (TryDequeue(record))
+    {
+        const char *prefix = "LOG: ";
+        auto fileDescriptor = 1;
+        if (record.type == LOG_WARNING)
+        {
+            prefix = "WRN: ";
+        }
+        else if (record.type == LOG_ERROR)
+        {
+            prefix = "ERR: ";
+            fileDescriptor = 2;
+        }
+        WriteRaw(fileDescriptor, prefix, std::strlen(prefix));
+        WriteRaw(fileDescriptor, record.message, record.length);
+        WriteRaw(fileDescriptor, "\n", 1);
+    }
+    consumerLock.clear(std::memory_order_release);
+}
+
+// Best effort attempt to get the pending messages out before the process dies.
+// If any thread is holding the consumer lock we give up
+static void CrashHandler(int signal)
+{
+    CrashDrain();
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+void Logger::Init()
+{
+    if (isRunning.load())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < LOG_RING_CAPACITY; i++)
+    {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePosition.store(0, std::memory_order_relaxed);
+    dequeuePosition.store(0, std::memory_order_relaxed);
+
+    std::signal(SIGSEGV, CrashHandler);
+    std::signal(SIGABRT, CrashHandler);
+    std::signal(SIGFPE, CrashHandler);
+    std::signal(SIGILL, CrashHandler);
+
+    isRunning.store(true, std::memory_order_release);
+    loggingThread = std::thread(LoggingThreadMain);
+}
+
+void Logger::Shutdown()
+{
+    if (!isRunning.exchange(false))
+    {
+        return;
+    }
+    loggingThread.join();
+    // A Submit() that saw the logger running can enqueue after the thread's last Drain()
+    Drain();
+}
+
+void Logger::Flush()
 {
-    LogEntry logEntry;
-    logEntry.type = LOG_INFO;
-    logEntry.message = "LOG: [ " + CurrentDateTimeToString() + " ]  " + message;
-    std::cout << termcolor::green << logEntry.message << termcolor::reset << std::endl;
-    messages.push_back(logEntry);
+    if (!isRunning.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    const auto target = enqueuePosition.load(std::memory_order_acquire);
+    while (dequeuePosition.load(std::memory_order_acquire) < target)
+    {
+        std::this_thread::yield();
+    }
+    // Wait for the writer to finish with the last batch
+    while (consumerLock.test_and_set(std::memory_order_acquire))
+    {
+        std::this_thread::yield();
+    }
+    consumerLock.clear(std::memory_order_release);
+}
+
+void Logger::Submit(LogRecord &record)
+{
+    record.time = std::chrono::system_clock::now();
+
+    if (!isRunning.load(std::memory_order_acquire))
+    {
+        WriteRecord(record);
+        std::cout.flush();
+        return;
+    }
+
+    if (!TryEnqueue(record))
+    {
+        droppedMessages.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Logger::Log(const std::string &message) { Write(LOG_INFO, "{}", message); }
+
+void Logger::Warn(const std::string &message) { Write(LOG_WARNING, "{}", message); }
+
+void Logger::Err(const std::string &message) { Write(LOG_ERROR, "{}", message); }
+
+void Logger::SetHistoryCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(historyMutex);
+    auto &history = GetHistoryBuffer();
+    history.clear();
+    history.shrink_to_fit();
+    history.resize(capacity);
+    historyNext = 0;
+    historyCount = 0;
+}
+
+size_t Logger::GetHistoryCapacity()
+{
+    std::lock_guard<std::mutex> lock(historyMutex);
+    auto &history = GetHistoryBuffer();
+    return history.size();
+}
+
+void Logger::SetHistoryLevel(LogType minimumType)
+{
+    std::lock_guard<std::mutex> lock(historyMutex);
+    historyLevel = minimumType;
+}
+
+std::vector<LogEntry> Logger::GetHistory(LogType minimumType, size_t maxEntries)
+{
+    std::lock_guard<std::mutex> lock(historyMutex);
+    auto &history = GetHistoryBuffer();
+    std::vector<LogEntry> result;
+
+    // Walk backwards from the newest entry so maxEntries keeps the most recent ones
+    for (size_t i = 0; i < historyCount && result.size() < maxEntries; i++)
+    {
+        const auto &entry = history[(historyNext + history.size() - 1 - i) % history.size()];
+        if (entry.type >= minimumType)
+        {
+            result.push_back(entry);
+        }
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
 }
 
-void Logger::Err(const std::string &message)
+void Logger::ClearHistory()
 {
-    LogEntry logEntry;
-    logEntry.type = LOG_ERROR;
-    logEntry.message = "ERR: [ " + CurrentDateTimeToString() + " ]  " + message;
-    std::cerr << termcolor::red << logEntry.message << termcolor::reset << std::endl;
-    messages.push_back(logEntry);
+    std::lock_guard<std::mutex> lock(historyMutex);
+    historyNext = 0;
+    historyCount = 0;
 }
@@ -1,6 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 enum LogType
@@ -16,10 +25,191 @@ struct LogEntry
     std::string message;
 };
 
+// Number of entries kept in the log history unless changed with SetHistoryCapacity()
+const size_t LOG_HISTORY_DEFAULT_CAPACITY = 1024;
+
+// Maximum number of characters of a single message, longer messages are truncated
+const unsigned int LOG_RECORD_MESSAGE_SIZE = 240;
+
+// A log record as it travels from the calling thread to the logging thread.
+// It has a fixed size so it can live in a preallocated ring buffer, the
+// timestamp is only turned into text on the logging thread
+struct LogRecord
+{
+    LogType type;
+    std::chrono::system_clock::time_point time;
+    unsigned int length;
+    char message[LOG_RECORD_MESSAGE_SIZE];
+};
+
+// Log calls below this level are compiled out by the LOGGER_* macros, for
+// example build with -DLOGGER_MIN_LEVEL=LOG_WARNING to drop all info logs
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL LOG_INFO
+#endif
+
+// The arguments of a disabled log call are never evaluated
+#define LOGGER_LOG(...)                                                                                                \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if constexpr (LOG_INFO >= LOGGER_MIN_LEVEL)                                                                    \
+        {                                                                                                              \
+            Logger::Log(__VA_ARGS__);                                                                                  \
+        }                                                                                                              \
+    } while (0)
+
+#define LOGGER_WARN(...)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if constexpr (LOG_WARNING >= LOGGER_MIN_LEVEL)                                                                 \
+        {                                                                                                              \
+            Logger::Warn(__VA_ARGS__);                                                                                 \
+        }                                                                                                              \
+    } while (0)
+
+#define LOGGER_ERR(...)                                                                                                \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if constexpr (LOG_ERROR >= LOGGER_MIN_LEVEL)                                                                   \
+        {                                                                                                              \
+            Logger::Err(__VA_ARGS__);                                                                                  \
+        }                                                                                                              \
+    } while (0)
+
+//////////////////////////////////////////////////////////////////////////////////
+// Logger
+//////////////////////////////////////////////////////////////////////////////////
+// Log(), Warn() and Err() only copy the message into a lock-free ring buffer, a
+// background thread started by Init() formats and writes the records. Before
+// Init() and after Shutdown() messages are written synchronously.
+// The most recent messages are kept in a fixed-capacity history, the oldest
+// entries are overwritten so memory use does not grow with uptime.
+//
+// The variadic overloads take a format string where every "{}" is replaced by
+// the next argument. Arguments are formatted straight into the fixed-size
+// record, so a log call does not allocate
+//////////////////////////////////////////////////////////////////////////////////
 class Logger
 {
+  private:
+    // Timestamps the record and hands it over to the logging thread
+    static void Submit(LogRecord &record);
+
+    static void AppendText(LogRecord &record, const char *text, size_t length)
+    {
+        const auto count = std::min<size_t>(length, LOG_RECORD_MESSAGE_SIZE - record.length);
+        std::memcpy(record.message + record.length, text, count);
+        record.length += static_cast<unsigned int>(count);
+    }
+
+    static void AppendArgument(LogRecord &record, const char *value)
+    {
+        if (!value)
+        {
+            value = "(null)";
+        }
+        AppendText(record, value, std::strlen(value));
+    }
+    static void AppendArgument(LogRecord &record, std::string_view value)
+    {
+        AppendText(record, value.data(), value.size());
+    }
+    static void AppendArgument(LogRecord &record, const std::string &value)
+    {
+        AppendText(record, value.data(), value.size());
+    }
+    static void AppendArgument(LogRecord &record, char value) { AppendText(record, &value, 1); }
+    static void AppendArgument(LogRecord &record, bool value)
+    {
+        AppendArgument(record, value ? "true" : "false");
+    }
+    // Other pointers print their address instead of converting to bool
+    static void AppendArgument(LogRecord &record, const void *value)
+    {
+        char buffer[2 + 2 * sizeof(uintptr_t)] = {'0', 'x'};
+        const auto result = std::to_chars(buffer + 2, std::end(buffer), reinterpret_cast<uintptr_t>(value), 16);
+        AppendText(record, buffer, result.ptr - buffer);
+    }
+
+    template <typename T> static std::enable_if_t<std::is_integral_v<T>> AppendArgument(LogRecord &record, T value)
+    {
+        char buffer[24];
+        const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+        AppendText(record, buffer, result.ptr - buffer);
+    }
+
+    template <typename T>
+    static std::enable_if_t<std::is_floating_point_v<T>> AppendArgument(LogRecord &record, T value)
+    {
+        char buffer[32];
+        const auto length = std::snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+        AppendText(record, buffer, std::min<size_t>(length, sizeof(buffer) - 1));
+    }
+
+    template <typename T> static std::enable_if_t<std::is_enum_v<T>> AppendArgument(LogRecord &record, T value)
+    {
+        AppendArgument(record, static_cast<std::underlying_type_t<T>>(value));
+    }
+
+    // Copies the format string up to the next "{}" and replaces it with the argument
+    template <typename T> static void FormatNext(LogRecord &record, const char *&format, const T &argument)
+    {
+        const char *placeholder = std::strstr(format, "{}");
+        if (!placeholder)
+        {
+            // More arguments than placeholders, the extra ones are ignored
+            return;
+        }
+        AppendText(record, format, placeholder - format);
+        AppendArgument(record, argument);
+        format = placeholder + 2;
+    }
+
+    template <typename... TArgs>
+    static void Write(LogType type, const char *format, const TArgs &...args)
+    {
+        LogRecord record;
+        record.type = type;
+        record.length = 0;
+        (FormatNext(record, format, args), ...);
+        AppendText(record, format, std::strlen(format));
+        Submit(record);
+    }
+
   public:
-    static std::vector<LogEntry> messages;
+    // Start and stop the background logging thread
+    static void Init();
+    static void Shutdown();
+
+    // Block until every message logged so far has been written
+    static void Flush();
+
     static void Log(const std::string &message);
+    static void Warn(const std::string &message);
     static void Err(const std::string &message);
+
+    template <typename... TArgs> static void Log(const char *format, const TArgs &...args)
+    {
+        Write(LOG_INFO, format, args...);
+    }
+    template <typename... TArgs> static void Warn(const char *format, const TArgs &...args)
+    {
+        Write(LOG_WARNING, format, args...);
+    }
+    template <typename... TArgs> static void Err(const char *format, const TArgs &...args)
+    {
+        Write(LOG_ERROR, format, args...);
+    }
+
+    // History management, safe to call from any thread.
+    // Changing the capacity discards the current history
+    static void SetHistoryCapacity(size_t capacity);
+    static size_t GetHistoryCapacity();
+    // Messages below this severity are printed but not kept in the history
+    static void SetHistoryLevel(LogType minimumType);
+
+    // Returns up to maxEntries of the newest entries with at least the given
+    // severity, oldest first
+    static std::vector<LogEntry> GetHistory(LogType minimumType = LOG_INFO, size_t maxEntries = SIZE_MAX);
+    static void ClearHistory();
 };
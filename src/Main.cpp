@@ -1,12 +1,120 @@
 #include "./Game/Game.hpp"
+#include "./Logger/Logger.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void PrintUsage(const char *program)
+{
+    // Let the warnings that led here come out before the usage
+    Logger::Flush();
+    std::fprintf(stderr,
+                 "Usage: %s [--headless] [--ticks N] [--check-allocations] [--level N] [--lua-gc MODE] "
+                 "[--lua-gc-budget US] [--no-hot-reload] [--vsync] [--seed N] [--record FILE] [--replay FILE]\n",
+                 program);
+    std::fprintf(stderr, "  --headless  run the simulation without a window or renderer, as fast as possible\n"
+                         "  --ticks N   stop after N simulation ticks\n"
+                         "  --check-allocations  fail if a frame allocates after the warmup "
+                         "(make TRACK_ALLOCATIONS=1)\n"
+                         "  --level N   start with assets/scripts/LevelN.lua, level 2 is a script stress test\n"
+                         "  --lua-gc MODE  auto (Lua decides), incremental (default) or generational (Lua 5.4)\n"
+                         "  --lua-gc-budget US  microseconds per frame the Lua collector may use\n"
+                         "  --no-hot-reload  don't reload assets and scripts when their files change\n"
+                         "  --vsync     pace the frames with the display's vsync instead of the frame pacer\n"
+                         "  --seed N    seed the random numbers of the scripts, a random seed is picked otherwise\n"
+                         "  --record FILE  write the seed and the input of every tick to FILE\n"
+                         "  --replay FILE  play a recording back instead of the input, works with --headless\n");
+}
 
 int main(int argc, char *argv[])
 {
+    Logger::Init();
+
     Game game;
 
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            game.SetHeadless(true);
+        }
+        else if (std::strcmp(argv[i], "--vsync") == 0)
+        {
+            game.SetVsync(true);
+        }
+        else if (std::strcmp(argv[i], "--no-hot-reload") == 0)
+        {
+            game.SetHotReload(false);
+        }
+        else if (std::strcmp(argv[i], "--check-allocations") == 0)
+        {
+            game.SetAllocationCheck(true);
+        }
+        else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+        {
+            game.SetMaxTicks(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            game.SetRandomSeed(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            game.SetRecordPath(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            game.SetReplayPath(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc)
+        {
+            game.SetStartLevel(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--lua-gc") == 0 && i + 1 < argc)
+        {
+            const char *mode = argv[++i];
+            auto isValid = true;
+            if (std::strcmp(mode, "auto") == 0)
+            {
+                isValid = game.SetScriptGcMode(SCRIPT_GC_AUTOMATIC);
+            }
+            else if (std::strcmp(mode, "incremental") == 0)
+            {
+                isValid = game.SetScriptGcMode(SCRIPT_GC_INCREMENTAL);
+            }
+            else if (std::strcmp(mode, "generational") == 0)
+            {
+                isValid = game.SetScriptGcMode(SCRIPT_GC_GENERATIONAL);
+            }
+            else
+            {
+                isValid = false;
+            }
+            if (!isValid)
+            {
+                PrintUsage(argv[0]);
+                Logger::Shutdown();
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--lua-gc-budget") == 0 && i + 1 < argc)
+        {
+            game.SetScriptGcBudget(std::chrono::microseconds(std::strtoull(argv[++i], nullptr, 10)));
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            Logger::Shutdown();
+            return 1;
+        }
+    }
+
     game.Initialize();
     game.Run();
     game.Destroy();
 
-    return 0;
+    Logger::Shutdown();
+
+    return game.HasAllocationCheckFailed() || game.HasReplayFailed() ? 1 : 0;
 }
@@ -0,0 +1,220 @@
+#include "AllocationTracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Plain arrays of atomics so they are usable before any constructor ran,
+// operator new can be called during static initialization
+static std::atomic<size_t> allocationCount[ALLOC_TAG_COUNT];
+static std::atomic<size_t> allocationBytes[ALLOC_TAG_COUNT];
+static std::atomic<size_t> freeCount[ALLOC_TAG_COUNT];
+static std::atomic<size_t> freedBytes[ALLOC_TAG_COUNT];
+static std::atomic<size_t> frameThreadAllocations{0};
+
+static AllocationCounters frameStart[ALLOC_TAG_COUNT];
+static AllocationCounters lastFrame[ALLOC_TAG_COUNT];
+static size_t frameThreadStart = 0;
+static size_t lastFrameThreadAllocations = 0;
+
+static thread_local AllocationTag currentTag = ALLOC_UNTAGGED;
+static thread_local bool isFrameThread = false;
+
+const char *AllocationTracker::GetTagName(AllocationTag tag)
+{
+    switch (tag)
+    {
+    case ALLOC_UNTAGGED:
+        return "Untagged";
+    case ALLOC_GAME:
+        return "Game";
+    case ALLOC_ECS:
+        return "ECS";
+    case ALLOC_RENDER:
+        return "Render";
+    case ALLOC_ASSETS:
+        return "Assets";
+    case ALLOC_LOGGER:
+        return "Logger";
+    case ALLOC_PROFILER:
+        return "Profiler";
+    case ALLOC_SCRIPTS:
+        return "Scripts";
+    case ALLOC_PHYSICS:
+        return "Physics";
+    case ALLOC_EVENTS:
+        return "Events";
+    default:
+        return "Unknown";
+    }
+}
+
+AllocationCounters AllocationTracker::GetTotal(AllocationTag tag)
+{
+    AllocationCounters counters;
+    counters.allocations = allocationCount[tag].load(std::memory_order_relaxed);
+    counters.bytes = allocationBytes[tag].load(std::memory_order_relaxed);
+    counters.frees = freeCount[tag].load(std::memory_order_relaxed);
+    counters.freedBytes = freedBytes[tag].load(std::memory_order_relaxed);
+    return counters;
+}
+
+void AllocationTracker::BeginFrame()
+{
+    isFrameThread = true;
+    frameThreadStart = frameThreadAllocations.load(std::memory_order_relaxed);
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++)
+    {
+        frameStart[tag] = GetTotal(static_cast<AllocationTag>(tag));
+    }
+}
+
+void AllocationTracker::EndFrame()
+{
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++)
+    {
+        const auto total = GetTotal(static_cast<AllocationTag>(tag));
+        lastFrame[tag].allocations = total.allocations - frameStart[tag].allocations;
+        lastFrame[tag].bytes = total.bytes - frameStart[tag].bytes;
+        lastFrame[tag].frees = total.frees - frameStart[tag].frees;
+        lastFrame[tag].freedBytes = total.freedBytes - frameStart[tag].freedBytes;
+    }
+    lastFrameThreadAllocations = frameThreadAllocations.load(std::memory_order_relaxed) - frameThreadStart;
+}
+
+AllocationCounters AllocationTracker::GetLastFrame(AllocationTag tag) { return lastFrame[tag]; }
+
+size_t AllocationTracker::GetLastFrameAllocations() { return lastFrameThreadAllocations; }
+
+AllocationTag AllocationTracker::SetCurrentTag(AllocationTag tag)
+{
+    const auto previousTag = currentTag;
+    currentTag = tag;
+    return previousTag;
+}
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+
+//////////////////////////////////////////////////////////////////////////////////
+// Global operator new/delete replacements
+//////////////////////////////////////////////////////////////////////////////////
+
+// Right in front of every block handed out
+struct alignas(std::max_align_t) AllocationHeader
+{
+    size_t size;
+    // From the start of the underlying allocation to the block
+    size_t offset;
+    AllocationTag tag;
+};
+
+// Counts the allocation and writes the header in front of the block at base + offset
+static void *TrackAllocation(void *base, size_t offset, size_t size)
+{
+    if (!base)
+    {
+        return nullptr;
+    }
+    allocationCount[currentTag].fetch_add(1, std::memory_order_relaxed);
+    allocationBytes[currentTag].fetch_add(size, std::memory_order_relaxed);
+    if (isFrameThread)
+    {
+        frameThreadAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto *block = static_cast<char *>(base) + offset;
+    auto *header = reinterpret_cast<AllocationHeader *>(block) - 1;
+    header->size = size;
+    header->offset = offset;
+    header->tag = currentTag;
+    return block;
+}
+
+static void *TrackedAllocate(size_t size)
+{
+    return TrackAllocation(std::malloc(sizeof(AllocationHeader) + size), sizeof(AllocationHeader), size);
+}
+
+static void *TrackedAllocateAligned(size_t size, std::align_val_t alignment)
+{
+    // The header takes whole alignment units so the block stays aligned, and
+    // aligned_alloc wants the size to be a multiple of the alignment
+    const auto align = std::max(static_cast<size_t>(alignment), alignof(AllocationHeader));
+    const auto offset = (sizeof(AllocationHeader) + align - 1) / align * align;
+    return TrackAllocation(std::aligned_alloc(align, (offset + size + align - 1) / align * align), offset, size);
+}
+
+static void TrackedFree(void *pointer)
+{
+    if (pointer)
+    {
+        const auto *header = static_cast<AllocationHeader *>(pointer) - 1;
+        freeCount[header->tag].fetch_add(1, std::memory_order_relaxed);
+        freedBytes[header->tag].fetch_add(header->size, std::memory_order_relaxed);
+        std::free(static_cast<char *>(pointer) - header->offset);
+    }
+}
+
+void *operator new(size_t size)
+{
+    if (auto pointer = TrackedAllocate(size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    if (auto pointer = TrackedAllocate(size))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return TrackedAllocate(size); }
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return TrackedAllocate(size); }
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    if (auto pointer = TrackedAllocateAligned(size, alignment))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    if (auto pointer = TrackedAllocateAligned(size, alignment))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept { TrackedFree(pointer); }
+
+void operator delete[](void *pointer) noexcept { TrackedFree(pointer); }
+
+void operator delete(void *pointer, size_t) noexcept { TrackedFree(pointer); }
+
+void operator delete[](void *pointer, size_t) noexcept { TrackedFree(pointer); }
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { TrackedFree(pointer); }
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { TrackedFree(pointer); }
+
+void operator delete(void *pointer, std::align_val_t) noexcept { TrackedFree(pointer); }
+
+void operator delete[](void *pointer, std::align_val_t) noexcept { TrackedFree(pointer); }
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept { TrackedFree(pointer); }
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept { TrackedFree(pointer); }
+
+#endif
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+
+//////////////////////////////////////////////////////////////////////////////////
+// AllocationTracker
+//////////////////////////////////////////////////////////////////////////////////
+// Counts heap allocations per subsystem. Building with
+// ENABLE_ALLOCATION_TRACKING (make TRACK_ALLOCATIONS=1) replaces the global
+// operator new/delete, every allocation is charged to the tag of the innermost
+// ALLOCATION_SCOPE on the allocating thread:
+//
+//     ALLOCATION_SCOPE(ALLOC_RENDER);
+//
+// Every block carries a small header with its tag and size, so a free is
+// charged to the tag the block was allocated under, whichever thread frees it.
+//
+// Without it the scopes compile to nothing and all counters stay zero
+//////////////////////////////////////////////////////////////////////////////////
+
+enum AllocationTag
+{
+    ALLOC_UNTAGGED,
+    ALLOC_GAME,
+    ALLOC_ECS,
+    ALLOC_RENDER,
+    ALLOC_ASSETS,
+    ALLOC_LOGGER,
+    ALLOC_PROFILER,
+    ALLOC_SCRIPTS,
+    ALLOC_PHYSICS,
+    ALLOC_EVENTS,
+    ALLOC_TAG_COUNT
+};
+
+struct AllocationCounters
+{
+    size_t allocations = 0;
+    size_t bytes = 0;
+    size_t frees = 0;
+    size_t freedBytes = 0;
+};
+
+class AllocationTracker
+{
+  public:
+    static constexpr bool IsEnabled()
+    {
+#ifdef ENABLE_ALLOCATION_TRACKING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static const char *GetTagName(AllocationTag tag);
+
+    // Counters since the start of the program
+    static AllocationCounters GetTotal(AllocationTag tag);
+
+    // Mark the frame boundaries, EndFrame() computes what happened in between.
+    // The thread calling BeginFrame() becomes the frame thread
+    static void BeginFrame();
+    static void EndFrame();
+    // Allocations of all threads during the last frame
+    static AllocationCounters GetLastFrame(AllocationTag tag);
+    // Allocations of all tags the frame thread made during the last frame.
+    // Other threads, like the logger's, allocate on their own schedule
+    static size_t GetLastFrameAllocations();
+
+    // Used by AllocationScope
+    static AllocationTag SetCurrentTag(AllocationTag tag);
+};
+
+class AllocationScope
+{
+  private:
+    AllocationTag previousTag;
+
+  public:
+    AllocationScope(AllocationTag tag) : previousTag(AllocationTracker::SetCurrentTag(tag)) {}
+    ~AllocationScope() { AllocationTracker::SetCurrentTag(previousTag); }
+
+    AllocationScope(const AllocationScope &) = delete;
+    AllocationScope &operator=(const AllocationScope &) = delete;
+};
+
+#ifdef ENABLE_ALLOCATION_TRACKING
+#define ALLOCATION_SCOPE_CONCAT_INNER(a, b) a##b
+#define ALLOCATION_SCOPE_CONCAT(a, b) ALLOCATION_SCOPE_CONCAT_INNER(a, b)
+#define ALLOCATION_SCOPE(tag) AllocationScope ALLOCATION_SCOPE_CONCAT(allocationScope, __LINE__)(tag)
+#else
+#define ALLOCATION_SCOPE(tag) ((void)0)
+#endif
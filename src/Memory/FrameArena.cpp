@@ -0,0 +1,85 @@
+#include "FrameArena.hpp"
+#include "../Logger/Logger.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+LinearArena::LinearArena(size_t capacity) : buffer(std::make_unique<std::byte[]>(capacity)), capacity(capacity) {}
+
+// Returns the aligned address of the next bytes in [base, base + size) or nullptr if they don't fit
+void *LinearArena::Bump(std::byte *base, size_t size, size_t &offset, size_t bytes, size_t alignment)
+{
+    const auto start = reinterpret_cast<uintptr_t>(base);
+    const auto aligned = (start + offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    const auto newOffset = aligned - start + bytes;
+    if (newOffset > size)
+    {
+        return nullptr;
+    }
+    offset = newOffset;
+    return reinterpret_cast<void *>(aligned);
+}
+
+void *LinearArena::do_allocate(size_t bytes, size_t alignment)
+{
+    requested += bytes + alignment;
+
+    if (auto pointer = Bump(buffer.get(), capacity, offset, bytes, alignment))
+    {
+        return pointer;
+    }
+
+    overflowAllocations++;
+    if (!overflowChunks.empty())
+    {
+        if (auto pointer = Bump(overflowChunks.back().get(), overflowChunkSize, overflowOffset, bytes, alignment))
+        {
+            return pointer;
+        }
+    }
+
+    overflowChunkSize = std::max(capacity, bytes + alignment);
+    overflowOffset = 0;
+    overflowChunks.push_back(std::make_unique<std::byte[]>(overflowChunkSize));
+    return Bump(overflowChunks.back().get(), overflowChunkSize, overflowOffset, bytes, alignment);
+}
+
+void LinearArena::do_deallocate(void *, size_t, size_t)
+{
+    // Released all at once in Reset()
+}
+
+bool LinearArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept { return this == &other; }
+
+void LinearArena::Reset()
+{
+    if (overflowAllocations > 0)
+    {
+        // Leave some headroom so a slowly growing workload doesn't reallocate every frame
+        const auto newCapacity = std::max(capacity * 2, requested + requested / 2);
+        LOGGER_WARN("Frame arena overflowed with {} allocations, growing it from {} to {} bytes", overflowAllocations,
+                    capacity, newCapacity);
+        buffer = std::make_unique<std::byte[]>(newCapacity);
+        capacity = newCapacity;
+        overflowChunks.clear();
+    }
+    offset = 0;
+    requested = 0;
+    overflowAllocations = 0;
+}
+
+FrameArena::FrameArena(size_t bytesPerFrame) : arenas{LinearArena(bytesPerFrame), LinearArena(bytesPerFrame)} {}
+
+std::pmr::memory_resource *FrameArena::GetCurrent() { return &arenas[current]; }
+
+std::pmr::memory_resource *FrameArena::GetPrevious() { return &arenas[1 - current]; }
+
+void FrameArena::EndFrame()
+{
+    current = 1 - current;
+    arenas[current].Reset();
+}
+
+size_t FrameArena::GetUsed() const { return arenas[current].GetUsed(); }
+
+size_t FrameArena::GetCapacity() const { return arenas[0].GetCapacity() + arenas[1].GetCapacity(); }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Bytes each half of the frame arena starts with
+const size_t FRAME_ARENA_DEFAULT_SIZE = 1024 * 1024;
+
+//////////////////////////////////////////////////////////////////////////////////
+// LinearArena
+//////////////////////////////////////////////////////////////////////////////////
+// Bump allocator behind a std::pmr::memory_resource. Deallocating is a no-op,
+// all memory is released at once by Reset(). When the buffer is full the arena
+// continues in extra heap chunks, and the next Reset() replaces them with one
+// buffer big enough for the peak so the spike does not hit the heap again
+//////////////////////////////////////////////////////////////////////////////////
+class LinearArena : public std::pmr::memory_resource
+{
+  private:
+    std::unique_ptr<std::byte[]> buffer;
+    size_t capacity;
+    size_t offset = 0;
+
+    // Chunks allocated after the buffer ran out, bumping continues in the last one
+    std::vector<std::unique_ptr<std::byte[]>> overflowChunks;
+    size_t overflowChunkSize = 0;
+    size_t overflowOffset = 0;
+
+    // Bytes requested since the last Reset(), including the ones that overflowed
+    size_t requested = 0;
+    size_t overflowAllocations = 0;
+
+    static void *Bump(std::byte *base, size_t size, size_t &offset, size_t bytes, size_t alignment);
+
+  protected:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+  public:
+    LinearArena(size_t capacity);
+
+    LinearArena(const LinearArena &) = delete;
+    LinearArena &operator=(const LinearArena &) = delete;
+
+    // Invalidates everything allocated from the arena
+    void Reset();
+
+    size_t GetCapacity() const { return capacity; }
+    size_t GetUsed() const { return offset; }
+    size_t GetOverflowAllocations() const { return overflowAllocations; }
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// FrameArena
+//////////////////////////////////////////////////////////////////////////////////
+// Double-buffered linear arena for transient per-frame data. Memory from
+// GetCurrent() stays valid until the end of the next frame, so data built in
+// one frame can still be read during the following one through GetPrevious().
+//
+//     std::pmr::vector<Foo> scratch(frameArena.GetCurrent());
+//////////////////////////////////////////////////////////////////////////////////
+class FrameArena
+{
+  private:
+    LinearArena arenas[2];
+    int current = 0;
+
+  public:
+    FrameArena(size_t bytesPerFrame = FRAME_ARENA_DEFAULT_SIZE);
+
+    std::pmr::memory_resource *GetCurrent();
+    std::pmr::memory_resource *GetPrevious();
+
+    // Call once at the end of every frame, recycles the arena of the previous frame
+    void EndFrame();
+
+    size_t GetUsed() const;
+    size_t GetCapacity() const;
+};
@@ -0,0 +1,134 @@
+#include "SmallObjectAllocator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+SmallObjectAllocator::~SmallObjectAllocator()
+{
+    for (auto page : pages)
+    {
+        std::free(page);
+    }
+}
+
+bool SmallObjectAllocator::AddPage(size_t sizeClass)
+{
+    auto page = static_cast<std::byte *>(std::malloc(SMALL_OBJECT_PAGE_SIZE));
+    if (!page)
+    {
+        return false;
+    }
+    pages.push_back(page);
+    stats.pageBytes += SMALL_OBJECT_PAGE_SIZE;
+
+    // Push the blocks in reverse so they are handed out in address order
+    const auto blockSize = (sizeClass + 1) * SMALL_OBJECT_GRANULARITY;
+    const auto blockCount = SMALL_OBJECT_PAGE_SIZE / blockSize;
+    for (auto i = blockCount; i > 0; i--)
+    {
+        auto block = reinterpret_cast<FreeBlock *>(page + (i - 1) * blockSize);
+        block->next = freeLists[sizeClass];
+        freeLists[sizeClass] = block;
+    }
+    return true;
+}
+
+void *SmallObjectAllocator::Allocate(size_t size)
+{
+    if (size == 0)
+    {
+        return nullptr;
+    }
+
+    if (size > SMALL_OBJECT_MAX_SIZE)
+    {
+        auto pointer = std::malloc(size);
+        if (pointer)
+        {
+            stats.largeAllocations++;
+            stats.bytesInUse += size;
+        }
+        return pointer;
+    }
+
+    const auto sizeClass = GetSizeClass(size);
+    if (!freeLists[sizeClass] && !AddPage(sizeClass))
+    {
+        return nullptr;
+    }
+    auto block = freeLists[sizeClass];
+    freeLists[sizeClass] = block->next;
+    stats.smallAllocations++;
+    stats.bytesInUse += size;
+    return block;
+}
+
+void SmallObjectAllocator::Deallocate(void *pointer, size_t size)
+{
+    if (!pointer)
+    {
+        return;
+    }
+    stats.bytesInUse -= size;
+
+    if (size > SMALL_OBJECT_MAX_SIZE)
+    {
+        std::free(pointer);
+        return;
+    }
+
+    const auto sizeClass = GetSizeClass(size);
+    auto block = static_cast<FreeBlock *>(pointer);
+    block->next = freeLists[sizeClass];
+    freeLists[sizeClass] = block;
+}
+
+void *SmallObjectAllocator::Reallocate(void *pointer, size_t oldSize, size_t newSize)
+{
+    if (!pointer)
+    {
+        return Allocate(newSize);
+    }
+    if (newSize == 0)
+    {
+        Deallocate(pointer, oldSize);
+        return nullptr;
+    }
+
+    // Both small and in the same class, the block is big enough already
+    if (oldSize <= SMALL_OBJECT_MAX_SIZE && newSize <= SMALL_OBJECT_MAX_SIZE &&
+        GetSizeClass(oldSize) == GetSizeClass(newSize))
+    {
+        stats.bytesInUse = stats.bytesInUse - oldSize + newSize;
+        return pointer;
+    }
+
+    // Both large, let the system grow or shrink the block in place if it can
+    if (oldSize > SMALL_OBJECT_MAX_SIZE && newSize > SMALL_OBJECT_MAX_SIZE)
+    {
+        auto newPointer = std::realloc(pointer, newSize);
+        if (newPointer)
+        {
+            stats.bytesInUse = stats.bytesInUse - oldSize + newSize;
+        }
+        return newPointer;
+    }
+
+    // Moving to another size class or between the pools and the system heap
+    auto newPointer = Allocate(newSize);
+    if (!newPointer)
+    {
+        // Lua expects shrinking to always succeed. The old block is big enough,
+        // it ends up in a smaller class when freed, which wastes but is safe
+        if (newSize < oldSize)
+        {
+            stats.bytesInUse = stats.bytesInUse - oldSize + newSize;
+            return pointer;
+        }
+        return nullptr;
+    }
+    std::memcpy(newPointer, pointer, std::min(oldSize, newSize));
+    Deallocate(pointer, oldSize);
+    return newPointer;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Requests up to this size are served from the pools, bigger ones go to malloc
+const size_t SMALL_OBJECT_MAX_SIZE = 256;
+// Block sizes are multiples of this, which is also the alignment of every block
+const size_t SMALL_OBJECT_GRANULARITY = 16;
+// Pages are carved into blocks of a single size
+const size_t SMALL_OBJECT_PAGE_SIZE = 64 * 1024;
+
+struct SmallObjectStats
+{
+    // Bytes handed out and not freed yet, small and large
+    size_t bytesInUse = 0;
+    // Bytes of all pool pages, used or not
+    size_t pageBytes = 0;
+    size_t smallAllocations = 0;
+    size_t largeAllocations = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// SmallObjectAllocator
+//////////////////////////////////////////////////////////////////////////////////
+// Segregated free lists for small blocks, one per size class. Allocating and
+// freeing a small block is a pointer pop or push with no locking, pages are
+// only returned to the system when the allocator is destroyed. The caller
+// passes the size back when freeing, like Lua's allocation function does, so
+// blocks carry no header. Not thread safe
+//////////////////////////////////////////////////////////////////////////////////
+class SmallObjectAllocator
+{
+  private:
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    static const size_t SIZE_CLASSES = SMALL_OBJECT_MAX_SIZE / SMALL_OBJECT_GRANULARITY;
+
+    FreeBlock *freeLists[SIZE_CLASSES] = {};
+    std::vector<void *> pages;
+    SmallObjectStats stats;
+
+    static size_t GetSizeClass(size_t size) { return (size - 1) / SMALL_OBJECT_GRANULARITY; }
+
+    // Splits a new page into blocks of the size class, returns false if out of memory
+    bool AddPage(size_t sizeClass);
+
+  public:
+    SmallObjectAllocator() = default;
+    ~SmallObjectAllocator();
+
+    SmallObjectAllocator(const SmallObjectAllocator &) = delete;
+    SmallObjectAllocator &operator=(const SmallObjectAllocator &) = delete;
+
+    // Returns nullptr if size is 0 or there is no memory left
+    void *Allocate(size_t size);
+    // size must be the size the block was allocated with
+    void Deallocate(void *pointer, size_t size);
+    // Behaves like realloc, except that the old size has to be passed in
+    void *Reallocate(void *pointer, size_t oldSize, size_t newSize);
+
+    const SmallObjectStats &GetStats() const { return stats; }
+};
@@ -0,0 +1,164 @@
+#include "Profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include "../Logger/Logger.hpp"
+#include "../Memory/AllocationTracker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+static const auto profilerEpoch = std::chrono::steady_clock::now();
+
+// Buffers are never freed so zones of threads that already exited can still be exported
+static std::mutex threadBuffersMutex;
+static std::vector<std::unique_ptr<ProfileThreadBuffer>> threadBuffers;
+
+static ProfileThreadBuffer *frameBuffer = nullptr;
+static size_t frameFirstEvent = 0;
+static std::vector<ProfileZoneStats> lastFrame;
+
+static_assert((PROFILER_EVENTS_PER_THREAD & (PROFILER_EVENTS_PER_THREAD - 1)) == 0,
+              "PROFILER_EVENTS_PER_THREAD has to be a power of two");
+
+// Index of the oldest zone of the buffer that has not been overwritten yet
+static size_t GetFirstKeptEvent(size_t count)
+{
+    return count > PROFILER_EVENTS_PER_THREAD ? count - PROFILER_EVENTS_PER_THREAD : 0;
+}
+
+int64_t Profiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profilerEpoch)
+        .count();
+}
+
+ProfileThreadBuffer &Profiler::GetThreadBuffer()
+{
+    thread_local ProfileThreadBuffer *buffer = nullptr;
+    if (!buffer)
+    {
+        ALLOCATION_SCOPE(ALLOC_PROFILER);
+        auto newBuffer = std::make_unique<ProfileThreadBuffer>();
+        newBuffer->events = std::make_unique<ProfileEvent[]>(PROFILER_EVENTS_PER_THREAD);
+
+        std::lock_guard<std::mutex> lock(threadBuffersMutex);
+        newBuffer->threadId = static_cast<uint32_t>(threadBuffers.size());
+        buffer = newBuffer.get();
+        threadBuffers.push_back(std::move(newBuffer));
+    }
+    return *buffer;
+}
+
+void Profiler::BeginFrame()
+{
+    frameBuffer = &GetThreadBuffer();
+    frameFirstEvent = frameBuffer->count.load(std::memory_order_relaxed);
+}
+
+void Profiler::EndFrame()
+{
+    // Reuse the vector so collecting the stats does not allocate once it has grown
+    lastFrame.clear();
+    if (!frameBuffer)
+    {
+        return;
+    }
+
+    const auto count = frameBuffer->count.load(std::memory_order_relaxed);
+    for (auto i = std::max(frameFirstEvent, GetFirstKeptEvent(count)); i < count; i++)
+    {
+        const auto &event = frameBuffer->events[i & (PROFILER_EVENTS_PER_THREAD - 1)];
+        const auto end = event.end.load(std::memory_order_relaxed);
+        if (end == 0)
+        {
+            continue;
+        }
+        const auto milliseconds = (end - event.start) / 1000000.0;
+
+        auto found = false;
+        for (auto &zone : lastFrame)
+        {
+            if (zone.depth == event.depth && zone.name == event.name)
+            {
+                zone.calls++;
+                zone.milliseconds += milliseconds;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            lastFrame.push_back({event.name, event.depth, 1, milliseconds});
+        }
+    }
+}
+
+const std::vector<ProfileZoneStats> &Profiler::GetLastFrame() { return lastFrame; }
+
+static void WriteJsonString(std::ofstream &file, const char *text)
+{
+    file << '"';
+    for (auto c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            file << '\\';
+        }
+        file << *c;
+    }
+    file << '"';
+}
+
+bool Profiler::WriteChromeTrace(const std::string &path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        LOGGER_ERR("Could not open {} to write the profiler trace", path);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(threadBuffersMutex);
+
+    // Timestamps and durations are in microseconds
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    auto first = true;
+    size_t written = 0;
+    for (const auto &buffer : threadBuffers)
+    {
+        // Oldest first, the ring may have wrapped around
+        const auto count = buffer->count.load(std::memory_order_acquire);
+        const auto firstEvent = GetFirstKeptEvent(count);
+        for (auto i = firstEvent; i < count; i++)
+        {
+            const auto &event = buffer->events[i & (PROFILER_EVENTS_PER_THREAD - 1)];
+            const auto end = event.end.load(std::memory_order_acquire);
+            if (end == 0)
+            {
+                continue;
+            }
+            file << (first ? "\n" : ",\n") << "{\"name\":";
+            WriteJsonString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"ts\":" << event.start / 1000.0
+                 << ",\"dur\":" << (end - event.start) / 1000.0 << '}';
+            first = false;
+            written++;
+        }
+        if (firstEvent > 0)
+        {
+            LOGGER_WARN("Profiler thread {} wrapped around, the trace starts after its first {} zones",
+                        buffer->threadId, firstEvent);
+        }
+    }
+    file << "\n]}\n";
+
+    LOGGER_LOG("Profiler trace with {} zones written to {}", written, path);
+    return true;
+}
+
+#endif
@@ -0,0 +1,131 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////////
+// Profiler
+//////////////////////////////////////////////////////////////////////////////////
+// Hierarchical frame profiler built from scoped zones. A zone measures the time
+// from its construction to the end of the enclosing scope:
+//
+//     PROFILE_SCOPE("MovementSystem::Update");
+//
+// Every thread records into its own preallocated ring buffer so recording never
+// takes a lock. Once a ring is full the oldest zones are overwritten, the trace
+// holds the most recent PROFILER_EVENTS_PER_THREAD zones of every thread. The
+// profiler only exists when building with ENABLE_PROFILER (make PROFILE=1),
+// otherwise all the macros compile to nothing
+//////////////////////////////////////////////////////////////////////////////////
+
+#ifdef ENABLE_PROFILER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+// name must be a string with static lifetime, e.g. a literal
+#define PROFILE_SCOPE(name) ProfileZone PROFILER_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_BEGIN_FRAME() Profiler::BeginFrame()
+#define PROFILE_END_FRAME() Profiler::EndFrame()
+#define PROFILE_WRITE_TRACE(path) Profiler::WriteChromeTrace(path)
+
+// Zones kept per thread, a power of two
+const size_t PROFILER_EVENTS_PER_THREAD = 1 << 20;
+
+struct ProfileEvent
+{
+    const char *name;
+    int64_t start;
+    // Zero while the zone is still open
+    std::atomic<int64_t> end;
+    uint32_t depth;
+};
+
+struct ProfileThreadBuffer
+{
+    uint32_t threadId;
+    std::unique_ptr<ProfileEvent[]> events;
+    // Zones recorded since the thread started, the newest one is at
+    // (count - 1) % PROFILER_EVENTS_PER_THREAD. Only written by the owning
+    // thread, read by the exporter
+    std::atomic<size_t> count{0};
+    uint32_t depth = 0;
+};
+
+// Time spent in a zone during the last frame, zones with the same name and
+// depth are summed up
+struct ProfileZoneStats
+{
+    const char *name;
+    uint32_t depth;
+    uint32_t calls;
+    double milliseconds;
+};
+
+class Profiler
+{
+  public:
+    // Nanoseconds since the profiler started
+    static int64_t Now();
+
+    // The calling thread's buffer, created on first use
+    static ProfileThreadBuffer &GetThreadBuffer();
+
+    // Mark the frame boundaries on the main thread, EndFrame() collects the
+    // zones recorded in between
+    static void BeginFrame();
+    static void EndFrame();
+    static const std::vector<ProfileZoneStats> &GetLastFrame();
+
+    // Writes every recorded zone of every thread in the Chrome trace event
+    // format (chrome://tracing, Perfetto)
+    static bool WriteChromeTrace(const std::string &path);
+};
+
+class ProfileZone
+{
+  private:
+    ProfileThreadBuffer &buffer;
+    ProfileEvent *event;
+    size_t index;
+
+  public:
+    ProfileZone(const char *name) : buffer(Profiler::GetThreadBuffer())
+    {
+        index = buffer.count.load(std::memory_order_relaxed);
+        event = &buffer.events[index & (PROFILER_EVENTS_PER_THREAD - 1)];
+        event->name = name;
+        event->depth = buffer.depth++;
+        event->end.store(0, std::memory_order_relaxed);
+        event->start = Profiler::Now();
+        buffer.count.store(index + 1, std::memory_order_release);
+    }
+
+    ~ProfileZone()
+    {
+        // A zone that stayed open for a whole ring of newer zones has been overwritten
+        if (buffer.count.load(std::memory_order_relaxed) - index <= PROFILER_EVENTS_PER_THREAD)
+        {
+            event->end.store(Profiler::Now(), std::memory_order_release);
+        }
+        buffer.depth--;
+    }
+
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+};
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_BEGIN_FRAME() ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+#define PROFILE_WRITE_TRACE(path) ((void)0)
+
+#endif
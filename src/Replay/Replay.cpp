@@ -0,0 +1,257 @@
+#include "Replay.hpp"
+#include "../Logger/Logger.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static const char REPLAY_MAGIC[4] = {'R', 'P', 'L', 'Y'};
+
+enum ReplayRecordType : uint8_t
+{
+    REPLAY_RECORD_ACTIONS = 1,
+    REPLAY_RECORD_CHECKSUM = 2
+};
+
+template <typename T> static void WriteValue(std::FILE *file, const T &value)
+{
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+// Reads a value at offset and moves past it, false if the data ends first
+template <typename T> static bool ReadValue(const std::vector<char> &data, size_t &offset, T &value)
+{
+    if (data.size() - offset < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+    if (file)
+    {
+        Close(header.tickCount);
+    }
+}
+
+bool ReplayRecorder::Open(const std::string &path, const ReplayHeader &header)
+{
+    file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        LOGGER_ERR("Could not create the replay file {}", path);
+        return false;
+    }
+    this->header = header;
+    previousDown = 0;
+
+    std::fwrite(REPLAY_MAGIC, sizeof(REPLAY_MAGIC), 1, file);
+    WriteValue(file, REPLAY_VERSION);
+    WriteValue(file, header.level);
+    WriteValue(file, header.ticksPerSecond);
+    WriteValue(file, header.randomSeed);
+    WriteValue(file, header.tickCount);
+    return true;
+}
+
+bool ReplayRecorder::IsOpen() const { return file != nullptr; }
+
+void ReplayRecorder::RecordActions(uint64_t tick, const ActionState &actions)
+{
+    if (!file || (actions.down == previousDown && actions.pressed == 0 && actions.released == 0))
+    {
+        return;
+    }
+    previousDown = actions.down;
+
+    WriteValue(file, REPLAY_RECORD_ACTIONS);
+    WriteValue(file, static_cast<uint32_t>(tick));
+    WriteValue(file, actions.down);
+    WriteValue(file, actions.pressed);
+    WriteValue(file, actions.released);
+}
+
+void ReplayRecorder::RecordChecksum(uint64_t tick, uint64_t checksum)
+{
+    if (!file)
+    {
+        return;
+    }
+    WriteValue(file, REPLAY_RECORD_CHECKSUM);
+    WriteValue(file, static_cast<uint32_t>(tick));
+    WriteValue(file, checksum);
+}
+
+void ReplayRecorder::Close(uint64_t tickCount)
+{
+    if (!file)
+    {
+        return;
+    }
+    // The tick count is the last field of the header
+    header.tickCount = tickCount;
+    std::fseek(file, sizeof(REPLAY_MAGIC) + 3 * sizeof(uint32_t) + sizeof(uint64_t), SEEK_SET);
+    WriteValue(file, header.tickCount);
+    std::fclose(file);
+    file = nullptr;
+}
+
+bool ReplayPlayer::Open(const std::string &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream)
+    {
+        LOGGER_ERR("Could not open the replay file {}", path);
+        return false;
+    }
+    const std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    char magic[sizeof(REPLAY_MAGIC)];
+    uint32_t version = 0;
+    if (!ReadValue(data, offset, magic) || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 ||
+        !ReadValue(data, offset, version))
+    {
+        LOGGER_ERR("{} is not a replay file", path);
+        return false;
+    }
+    if (version != REPLAY_VERSION)
+    {
+        LOGGER_ERR("{} is a version {} replay, only version {} can be played", path, version, REPLAY_VERSION);
+        return false;
+    }
+    if (!ReadValue(data, offset, header.level) || !ReadValue(data, offset, header.ticksPerSecond) ||
+        !ReadValue(data, offset, header.randomSeed) || !ReadValue(data, offset, header.tickCount))
+    {
+        LOGGER_ERR("The header of the replay file {} is cut off", path);
+        return false;
+    }
+    if (header.ticksPerSecond == 0 || header.ticksPerSecond > INT_MAX)
+    {
+        LOGGER_ERR("The replay file {} has an invalid tick rate of {} ticks/s", path, header.ticksPerSecond);
+        return false;
+    }
+
+    actionRecords.clear();
+    checksumRecords.clear();
+    while (offset < data.size())
+    {
+        uint8_t type;
+        uint32_t tick;
+        auto isComplete = ReadValue(data, offset, type) && ReadValue(data, offset, tick);
+        if (isComplete && type == REPLAY_RECORD_ACTIONS)
+        {
+            ActionRecord record = {tick, {}};
+            isComplete = ReadValue(data, offset, record.actions.down) &&
+                         ReadValue(data, offset, record.actions.pressed) &&
+                         ReadValue(data, offset, record.actions.released);
+            if (isComplete)
+            {
+                actionRecords.push_back(record);
+            }
+        }
+        else if (isComplete && type == REPLAY_RECORD_CHECKSUM)
+        {
+            ChecksumRecord record = {tick, 0};
+            isComplete = ReadValue(data, offset, record.checksum);
+            if (isComplete)
+            {
+                checksumRecords.push_back(record);
+            }
+        }
+        else if (isComplete)
+        {
+            LOGGER_ERR("The replay file {} has an unknown record type {}", path, type);
+            return false;
+        }
+        if (!isComplete)
+        {
+            // The game stopped in the middle of writing, everything before is fine
+            LOGGER_WARN("The replay file {} ends in the middle of a record", path);
+            break;
+        }
+    }
+
+    nextAction = 0;
+    nextChecksum = 0;
+    down = 0;
+    checkedCount = 0;
+    hasDiverged = false;
+    divergedTick = 0;
+    return true;
+}
+
+const ReplayHeader &ReplayPlayer::GetHeader() const { return header; }
+
+uint64_t ReplayPlayer::GetTickCount() const
+{
+    if (header.tickCount > 0)
+    {
+        return header.tickCount;
+    }
+    // Not closed properly, play up to the last tick something was recorded for
+    uint64_t lastTick = 0;
+    if (!actionRecords.empty())
+    {
+        lastTick = actionRecords.back().tick + 1;
+    }
+    if (!checksumRecords.empty())
+    {
+        lastTick = std::max(lastTick, checksumRecords.back().tick);
+    }
+    return lastTick;
+}
+
+ActionState ReplayPlayer::GetActions(uint64_t tick)
+{
+    while (nextAction < actionRecords.size() && actionRecords[nextAction].tick < tick)
+    {
+        nextAction++;
+    }
+    if (nextAction < actionRecords.size() && actionRecords[nextAction].tick == tick)
+    {
+        const auto &actions = actionRecords[nextAction++].actions;
+        down = actions.down;
+        return actions;
+    }
+    // Not recorded, the same actions are still held
+    ActionState actions;
+    actions.down = down;
+    return actions;
+}
+
+bool ReplayPlayer::CheckChecksum(uint64_t tick, uint64_t checksum)
+{
+    while (nextChecksum < checksumRecords.size() && checksumRecords[nextChecksum].tick < tick)
+    {
+        nextChecksum++;
+    }
+    if (nextChecksum >= checksumRecords.size() || checksumRecords[nextChecksum].tick != tick)
+    {
+        return true;
+    }
+
+    checkedCount++;
+    if (checksumRecords[nextChecksum++].checksum == checksum)
+    {
+        return true;
+    }
+    if (!hasDiverged)
+    {
+        hasDiverged = true;
+        divergedTick = tick;
+    }
+    return false;
+}
+
+size_t ReplayPlayer::GetCheckedCount() const { return checkedCount; }
+
+bool ReplayPlayer::HasDiverged() const { return hasDiverged; }
+
+uint64_t ReplayPlayer::GetDivergedTick() const { return divergedTick; }
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "../Input/Input.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+const uint32_t REPLAY_VERSION = 1;
+// Ticks between two checksums of the simulation state
+const uint64_t REPLAY_CHECKSUM_INTERVAL = 60;
+
+// What the simulation needs to start the same way again
+struct ReplayHeader
+{
+    uint32_t level = 1;
+    uint32_t ticksPerSecond = 60;
+    uint64_t randomSeed = 0;
+    // Written when the recording is closed, 0 if the game did not get that far
+    uint64_t tickCount = 0;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// Replays
+//////////////////////////////////////////////////////////////////////////////////
+// The simulation only depends on the level, the tick rate, the random seed and
+// the actions of every tick, so that is all a recording holds. Ticks whose
+// actions are the same as the tick before (nothing pressed or released, the
+// same actions held) are not written, a session without input is a header and
+// the checksums. The checksums of the simulation state every
+// REPLAY_CHECKSUM_INTERVAL ticks tell where a replay went a different way.
+//
+// File layout, native byte order:
+//   "RPLY", version, level, ticks per second (uint32), seed, tick count (uint64)
+//   records of a type byte and a tick (uint32):
+//     REPLAY_RECORD_ACTIONS   down, pressed, released (uint32)
+//     REPLAY_RECORD_CHECKSUM  checksum (uint64)
+//////////////////////////////////////////////////////////////////////////////////
+class ReplayRecorder
+{
+  private:
+    std::FILE *file = nullptr;
+    ReplayHeader header;
+    ActionMask previousDown = 0;
+
+  public:
+    ReplayRecorder() = default;
+    ~ReplayRecorder();
+
+    ReplayRecorder(const ReplayRecorder &) = delete;
+    ReplayRecorder &operator=(const ReplayRecorder &) = delete;
+
+    // Creates the file and writes the header, returns false if it can't be written
+    bool Open(const std::string &path, const ReplayHeader &header);
+    bool IsOpen() const;
+
+    void RecordActions(uint64_t tick, const ActionState &actions);
+    void RecordChecksum(uint64_t tick, uint64_t checksum);
+
+    // Writes the number of recorded ticks into the header and closes the file
+    void Close(uint64_t tickCount);
+};
+
+class ReplayPlayer
+{
+  private:
+    struct ActionRecord
+    {
+        uint64_t tick;
+        ActionState actions;
+    };
+
+    struct ChecksumRecord
+    {
+        uint64_t tick;
+        uint64_t checksum;
+    };
+
+    ReplayHeader header;
+    std::vector<ActionRecord> actionRecords;
+    std::vector<ChecksumRecord> checksumRecords;
+    size_t nextAction = 0;
+    size_t nextChecksum = 0;
+    ActionMask down = 0;
+
+    size_t checkedCount = 0;
+    bool hasDiverged = false;
+    // Tick of the first checksum that did not match
+    uint64_t divergedTick = 0;
+
+  public:
+    // Reads the whole recording, returns false if it is missing or broken
+    bool Open(const std::string &path);
+
+    const ReplayHeader &GetHeader() const;
+    // Ticks that can be replayed
+    uint64_t GetTickCount() const;
+
+    // The recorded actions of the tick, ticks have to be asked for in order
+    ActionState GetActions(uint64_t tick);
+    // Compares with the recorded checksum of the tick if there is one, returns false on a mismatch
+    bool CheckChecksum(uint64_t tick, uint64_t checksum);
+
+    size_t GetCheckedCount() const;
+    bool HasDiverged() const;
+    uint64_t GetDivergedTick() const;
+};
@@ -0,0 +1,109 @@
+#include "ScriptRuntime.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Profiler/Profiler.hpp"
+
+#include <algorithm>
+
+ScriptRuntime::ScriptRuntime() : lua(sol::default_at_panic, &ScriptRuntime::Allocate, &allocator)
+{
+    SetGcMode(gcMode);
+}
+
+void *ScriptRuntime::Allocate(void *userData, void *pointer, size_t oldSize, size_t newSize)
+{
+    auto allocator = static_cast<SmallObjectAllocator *>(userData);
+    // For new blocks Lua passes the type of the object in oldSize, not a size
+    return allocator->Reallocate(pointer, pointer ? oldSize : 0, newSize);
+}
+
+size_t ScriptRuntime::GetLuaBytes() const
+{
+    auto state = lua.lua_state();
+    return static_cast<size_t>(lua_gc(state, LUA_GCCOUNT, 0)) * 1024 + lua_gc(state, LUA_GCCOUNTB, 0);
+}
+
+void ScriptRuntime::UpdateEmergencyThreshold()
+{
+    emergencyBytes = std::max(GetLuaBytes() * SCRIPT_GC_EMERGENCY_FACTOR, SCRIPT_GC_MIN_EMERGENCY_BYTES);
+}
+
+bool ScriptRuntime::SetGcMode(ScriptGcMode mode)
+{
+    auto state = lua.lua_state();
+
+#if LUA_VERSION_NUM >= 504
+    // The zeros keep Lua's tuning, LUA_GCGEN reads two of them and LUA_GCINC three
+    if (mode == SCRIPT_GC_GENERATIONAL)
+    {
+        lua_gc(state, LUA_GCGEN, 0, 0);
+    }
+    else
+    {
+        lua_gc(state, LUA_GCINC, 0, 0, 0);
+    }
+#else
+    if (mode == SCRIPT_GC_GENERATIONAL)
+    {
+        LOGGER_WARN("The generational Lua collector needs Lua 5.4, keeping the current mode");
+        return false;
+    }
+#endif
+
+    if (mode == SCRIPT_GC_AUTOMATIC)
+    {
+        lua_gc(state, LUA_GCRESTART, 0);
+    }
+    else
+    {
+        // Explicit steps still work while the collector is stopped
+        lua_gc(state, LUA_GCSTOP, 0);
+        UpdateEmergencyThreshold();
+    }
+    gcMode = mode;
+    return true;
+}
+
+void ScriptRuntime::SetGcBudget(std::chrono::nanoseconds budget) { gcBudget = budget; }
+
+void ScriptRuntime::CollectGarbage(std::chrono::nanoseconds idleTime)
+{
+    lastSteps = 0;
+    lastMilliseconds = 0.0;
+    if (gcMode == SCRIPT_GC_AUTOMATIC)
+    {
+        return;
+    }
+    PROFILE_FUNCTION();
+
+    auto state = lua.lua_state();
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::min(gcBudget, idleTime);
+    do
+    {
+        lastSteps++;
+        // Returns 1 when the step finished a cycle, the next one starts with the next frame
+        if (lua_gc(state, LUA_GCSTEP, SCRIPT_GC_STEP_KB))
+        {
+            completedCycles++;
+            UpdateEmergencyThreshold();
+            break;
+        }
+        // A generational step is a whole young collection, one per frame is plenty
+    } while (gcMode != SCRIPT_GC_GENERATIONAL && std::chrono::steady_clock::now() < deadline);
+
+    // The scripts allocate faster than the steps can keep up with
+    if (GetLuaBytes() > emergencyBytes)
+    {
+        LOGGER_WARN("Lua memory reached {} bytes, running a full collection", GetLuaBytes());
+        lua_gc(state, LUA_GCCOLLECT, 0);
+        emergencyCollections++;
+        UpdateEmergencyThreshold();
+    }
+
+    lastMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+ScriptMemoryStats ScriptRuntime::GetMemoryStats() const
+{
+    return {GetLuaBytes(), allocator.GetStats(), lastSteps, lastMilliseconds, completedCycles, emergencyCollections};
+}
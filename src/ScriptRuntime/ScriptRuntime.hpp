@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../Memory/SmallObjectAllocator.hpp"
+#include <chrono>
+#include <cstddef>
+#include <sol/sol.hpp>
+
+enum ScriptGcMode
+{
+    // Lua collects on its own whenever its allocation debt says so
+    SCRIPT_GC_AUTOMATIC,
+    // The engine runs incremental steps in the idle time of every frame
+    SCRIPT_GC_INCREMENTAL,
+    // Like SCRIPT_GC_INCREMENTAL with Lua 5.4's generational collector
+    SCRIPT_GC_GENERATIONAL
+};
+
+// Time the collector may spend per frame unless changed with SetGcBudget()
+const std::chrono::microseconds SCRIPT_GC_DEFAULT_BUDGET(1000);
+// Work done by one incremental step, in the kilobytes of allocation Lua would pay it for
+const int SCRIPT_GC_STEP_KB = 8;
+// Memory use that forces a full collection is this many times the use after the
+// last cycle, but never below SCRIPT_GC_MIN_EMERGENCY_BYTES
+const size_t SCRIPT_GC_EMERGENCY_FACTOR = 2;
+const size_t SCRIPT_GC_MIN_EMERGENCY_BYTES = 8 * 1024 * 1024;
+
+struct ScriptMemoryStats
+{
+    // Memory in use as counted by Lua
+    size_t luaBytes;
+    SmallObjectStats allocator;
+    // Collector work of the last CollectGarbage() call
+    size_t steps;
+    double milliseconds;
+    size_t completedCycles;
+    size_t emergencyCollections;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// ScriptRuntime
+//////////////////////////////////////////////////////////////////////////////////
+// Owns the Lua state, its memory and its garbage collector. All of Lua's
+// allocations go through a pooled small-object allocator, and in the engine
+// controlled modes Lua never collects by itself: the game calls
+// CollectGarbage() once per frame after presenting, with the time left until
+// the next frame is due, so collection work lands in idle time instead of in
+// the middle of a script. At least one step runs every frame so the collector
+// keeps up when there is no idle time, and if memory still runs away a full
+// collection is forced.
+//
+// The allocator gets its pages from malloc, so Lua memory does not show up in
+// the AllocationTracker counters. GetMemoryStats() reports it instead
+//////////////////////////////////////////////////////////////////////////////////
+class ScriptRuntime
+{
+  private:
+    // Declared before the state so it outlives it
+    SmallObjectAllocator allocator;
+    sol::state lua;
+
+    ScriptGcMode gcMode = SCRIPT_GC_INCREMENTAL;
+    std::chrono::nanoseconds gcBudget = SCRIPT_GC_DEFAULT_BUDGET;
+    size_t emergencyBytes = SCRIPT_GC_MIN_EMERGENCY_BYTES;
+
+    size_t lastSteps = 0;
+    double lastMilliseconds = 0.0;
+    size_t completedCycles = 0;
+    size_t emergencyCollections = 0;
+
+    // lua_Alloc implementation on top of the allocator
+    static void *Allocate(void *userData, void *pointer, size_t oldSize, size_t newSize);
+
+    size_t GetLuaBytes() const;
+    void UpdateEmergencyThreshold();
+
+  public:
+    ScriptRuntime();
+
+    ScriptRuntime(const ScriptRuntime &) = delete;
+    ScriptRuntime &operator=(const ScriptRuntime &) = delete;
+
+    sol::state &GetState() { return lua; }
+
+    // Returns false if the mode is not available with this Lua version
+    bool SetGcMode(ScriptGcMode mode);
+    ScriptGcMode GetGcMode() const { return gcMode; }
+    void SetGcBudget(std::chrono::nanoseconds budget);
+
+    // Runs collector steps for at most min(budget, idleTime), does nothing in
+    // SCRIPT_GC_AUTOMATIC mode
+    void CollectGarbage(std::chrono::nanoseconds idleTime);
+
+    ScriptMemoryStats GetMemoryStats() const;
+};
@@ -0,0 +1,334 @@
+#include "AabbTree.hpp"
+
+#include <utility>
+
+AabbTree::AabbTree(float margin) : margin(margin) {}
+
+int AabbTree::AllocateNode()
+{
+    if (freeList == AABB_TREE_NULL)
+    {
+        // The vector grows geometrically, node indices stay valid but references don't
+        nodes.emplace_back();
+        freeList = static_cast<int>(nodes.size() - 1);
+        nodes[freeList].parent = AABB_TREE_NULL;
+    }
+
+    const auto node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node].parent = AABB_TREE_NULL;
+    nodes[node].child1 = AABB_TREE_NULL;
+    nodes[node].child2 = AABB_TREE_NULL;
+    nodes[node].height = 0;
+    nodes[node].userData = -1;
+    return node;
+}
+
+void AabbTree::FreeNode(int node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int AabbTree::CreateProxy(const Aabb &box, int userData)
+{
+    const auto proxy = AllocateNode();
+    auto &node = nodes[proxy];
+    node.tight = box;
+    node.box = {box.min - glm::vec2(margin), box.max + glm::vec2(margin)};
+    node.userData = userData;
+    InsertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void AabbTree::DestroyProxy(int proxy)
+{
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    proxyCount--;
+}
+
+bool AabbTree::MoveProxy(int proxy, const Aabb &box)
+{
+    auto &node = nodes[proxy];
+    node.tight = box;
+    if (node.box.Contains(box))
+    {
+        return false;
+    }
+
+    RemoveLeaf(proxy);
+    nodes[proxy].box = {box.min - glm::vec2(margin), box.max + glm::vec2(margin)};
+    InsertLeaf(proxy);
+    return true;
+}
+
+void AabbTree::Clear()
+{
+    nodes.clear();
+    root = AABB_TREE_NULL;
+    freeList = AABB_TREE_NULL;
+    proxyCount = 0;
+}
+
+void AabbTree::InsertLeaf(int leaf)
+{
+    if (root == AABB_TREE_NULL)
+    {
+        root = leaf;
+        nodes[root].parent = AABB_TREE_NULL;
+        return;
+    }
+
+    // Walk down to the sibling that adds the least perimeter to the tree. Going
+    // down a level costs the growth of the node's box, as every box above the
+    // new leaf grows with it
+    const auto leafBox = nodes[leaf].box;
+    auto index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        const auto &node = nodes[index];
+        const auto perimeter = node.box.GetPerimeter();
+        const auto combinedPerimeter = Aabb::Union(node.box, leafBox).GetPerimeter();
+
+        // Making the leaf a sibling of this node
+        const auto cost = 2.0f * combinedPerimeter;
+        // Pushing the leaf further down
+        const auto inheritanceCost = 2.0f * (combinedPerimeter - perimeter);
+
+        const auto descendCost = [&](int child)
+        {
+            const auto &childBox = nodes[child].box;
+            const auto grownPerimeter = Aabb::Union(leafBox, childBox).GetPerimeter();
+            if (nodes[child].IsLeaf())
+            {
+                return grownPerimeter + inheritanceCost;
+            }
+            return grownPerimeter - childBox.GetPerimeter() + inheritanceCost;
+        };
+        const auto cost1 = descendCost(node.child1);
+        const auto cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2)
+        {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    // A new parent takes the place of the sibling and gets the sibling and the leaf as children
+    const auto sibling = index;
+    const auto oldParent = nodes[sibling].parent;
+    const auto newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = Aabb::Union(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == AABB_TREE_NULL)
+    {
+        root = newParent;
+    }
+    else if (nodes[oldParent].child1 == sibling)
+    {
+        nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    Refit(nodes[leaf].parent);
+}
+
+void AabbTree::RemoveLeaf(int leaf)
+{
+    if (leaf == root)
+    {
+        root = AABB_TREE_NULL;
+        return;
+    }
+
+    // The sibling takes the place of the parent
+    const auto parent = nodes[leaf].parent;
+    const auto grandParent = nodes[parent].parent;
+    const auto sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    FreeNode(parent);
+
+    nodes[sibling].parent = grandParent;
+    if (grandParent == AABB_TREE_NULL)
+    {
+        root = sibling;
+        return;
+    }
+    if (nodes[grandParent].child1 == parent)
+    {
+        nodes[grandParent].child1 = sibling;
+    }
+    else
+    {
+        nodes[grandParent].child2 = sibling;
+    }
+    Refit(grandParent);
+}
+
+void AabbTree::Refit(int index)
+{
+    while (index != AABB_TREE_NULL)
+    {
+        index = Balance(index);
+
+        auto &node = nodes[index];
+        const auto &child1 = nodes[node.child1];
+        const auto &child2 = nodes[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.box = Aabb::Union(child1.box, child2.box);
+
+        index = node.parent;
+    }
+}
+
+int AabbTree::Balance(int a)
+{
+    auto &nodeA = nodes[a];
+    if (nodeA.IsLeaf() || nodeA.height < 2)
+    {
+        return a;
+    }
+
+    const auto b = nodeA.child1;
+    const auto c = nodeA.child2;
+    auto &nodeB = nodes[b];
+    auto &nodeC = nodes[c];
+    const auto balance = nodeC.height - nodeB.height;
+
+    // Makes child the root of the subtree in place of a, a keeps its other child
+    // plus the lower of child's children, child keeps the higher one
+    const auto rotateUp = [&](int child, int other, bool childIsFirst)
+    {
+        auto &nodeChild = nodes[child];
+        const auto grandChild1 = nodeChild.child1;
+        const auto grandChild2 = nodeChild.child2;
+
+        nodeChild.child1 = a;
+        nodeChild.parent = nodeA.parent;
+        nodeA.parent = child;
+        if (nodeChild.parent == AABB_TREE_NULL)
+        {
+            root = child;
+        }
+        else if (nodes[nodeChild.parent].child1 == a)
+        {
+            nodes[nodeChild.parent].child1 = child;
+        }
+        else
+        {
+            nodes[nodeChild.parent].child2 = child;
+        }
+
+        const auto higher = nodes[grandChild1].height > nodes[grandChild2].height ? grandChild1 : grandChild2;
+        const auto lower = higher == grandChild1 ? grandChild2 : grandChild1;
+        nodeChild.child2 = higher;
+        if (childIsFirst)
+        {
+            nodeA.child1 = lower;
+        }
+        else
+        {
+            nodeA.child2 = lower;
+        }
+        nodes[lower].parent = a;
+
+        nodeA.box = Aabb::Union(nodes[other].box, nodes[lower].box);
+        nodeA.height = 1 + std::max(nodes[other].height, nodes[lower].height);
+        nodeChild.box = Aabb::Union(nodeA.box, nodes[higher].box);
+        nodeChild.height = 1 + std::max(nodeA.height, nodes[higher].height);
+        return child;
+    };
+
+    if (balance > 1)
+    {
+        return rotateUp(c, b, false);
+    }
+    if (balance < -1)
+    {
+        return rotateUp(b, c, true);
+    }
+    return a;
+}
+
+// Where the ray enters the box, false if it misses it or enters it after maxDistance
+static bool RayEntersBox(const Aabb &box, glm::vec2 origin, glm::vec2 direction, float maxDistance, float &distance)
+{
+    auto enter = 0.0f;
+    auto exit = maxDistance;
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (direction[axis] == 0.0f)
+        {
+            // Parallel to the slab, it has to start inside of it
+            if (origin[axis] < box.min[axis] || origin[axis] > box.max[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+        const auto inverse = 1.0f / direction[axis];
+        auto slabEnter = (box.min[axis] - origin[axis]) * inverse;
+        auto slabExit = (box.max[axis] - origin[axis]) * inverse;
+        if (slabEnter > slabExit)
+        {
+            std::swap(slabEnter, slabExit);
+        }
+        enter = std::max(enter, slabEnter);
+        exit = std::min(exit, slabExit);
+        if (enter > exit)
+        {
+            return false;
+        }
+    }
+    distance = enter;
+    return true;
+}
+
+bool AabbTree::Raycast(glm::vec2 origin, glm::vec2 direction, float maxDistance, RaycastHit &hit) const
+{
+    if (root == AABB_TREE_NULL)
+    {
+        return false;
+    }
+
+    // Every hit shortens the ray, the nodes it no longer reaches are skipped
+    auto closest = maxDistance;
+    auto found = false;
+    int stack[AABB_TREE_STACK_SIZE];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0)
+    {
+        const auto &node = nodes[stack[--count]];
+        float distance;
+        if (!RayEntersBox(node.box, origin, direction, closest, distance))
+        {
+            continue;
+        }
+        if (node.IsLeaf())
+        {
+            if (RayEntersBox(node.tight, origin, direction, closest, distance))
+            {
+                closest = distance;
+                hit = {node.userData, distance};
+                found = true;
+            }
+            continue;
+        }
+        stack[count++] = node.child1;
+        stack[count++] = node.child2;
+    }
+    return found;
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Index of "no node"
+const int AABB_TREE_NULL = -1;
+// How far the boxes stored in the tree reach past the real ones, in pixels.
+// A proxy that moves less than this stays where it is in the tree
+const float AABB_TREE_DEFAULT_MARGIN = 16.0f;
+// Depth of the traversal stacks, balancing keeps the height around 1.44 log2(n)
+const int AABB_TREE_STACK_SIZE = 256;
+
+// Axis aligned box, touching boxes overlap
+struct Aabb
+{
+    glm::vec2 min;
+    glm::vec2 max;
+
+    bool Overlaps(const Aabb &other) const
+    {
+        return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+    }
+
+    bool Contains(const Aabb &other) const
+    {
+        return min.x <= other.min.x && min.y <= other.min.y && other.max.x <= max.x && other.max.y <= max.y;
+    }
+
+    // Squared distance from a point to the box, 0 inside of it
+    float GetDistanceSquared(glm::vec2 point) const
+    {
+        const auto closest = glm::clamp(point, min, max);
+        const auto delta = point - closest;
+        return delta.x * delta.x + delta.y * delta.y;
+    }
+
+    float GetPerimeter() const { return 2.0f * ((max.x - min.x) + (max.y - min.y)); }
+
+    static Aabb Union(const Aabb &a, const Aabb &b) { return {glm::min(a.min, b.min), glm::max(a.max, b.max)}; }
+};
+
+struct RaycastHit
+{
+    int userData;
+    // Along the ray, from its origin to where it enters the box
+    float distance;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// AabbTree
+//////////////////////////////////////////////////////////////////////////////////
+// Dynamic bounding volume tree. Every proxy is a leaf holding the real box of
+// an object and a fat copy grown by a margin, the inner nodes bound their two
+// children. Moving a proxy within its fat box is free, only a proxy that
+// leaves it is taken out and inserted again, which refits and rebalances the
+// nodes above it. Leaves are inserted next to the sibling that grows the tree's
+// perimeter the least and rotations keep the tree balanced, so queries visit
+// O(log n) nodes plus the ones they find.
+//
+// The nodes live in a single vector with a free list, proxies are node indices
+// and stay valid until they are destroyed. The queries don't allocate
+//////////////////////////////////////////////////////////////////////////////////
+class AabbTree
+{
+  private:
+    struct Node
+    {
+        // Fat box for leaves, bounds of both children for the other nodes
+        Aabb box;
+        // The real box of a leaf
+        Aabb tight;
+        // Next free node while the node is in the free list
+        int parent;
+        int child1;
+        int child2;
+        // Leaves are 0, free nodes -1
+        int height;
+        int userData;
+
+        bool IsLeaf() const { return child1 == AABB_TREE_NULL; }
+    };
+
+    std::vector<Node> nodes;
+    int root = AABB_TREE_NULL;
+    int freeList = AABB_TREE_NULL;
+    size_t proxyCount = 0;
+    float margin;
+
+    int AllocateNode();
+    void FreeNode(int node);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    // Rotates the subtree if it is out of balance, returns its new root
+    int Balance(int node);
+    // Recomputes the boxes and heights from node up to the root
+    void Refit(int node);
+
+  public:
+    AabbTree(float margin = AABB_TREE_DEFAULT_MARGIN);
+
+    int CreateProxy(const Aabb &box, int userData);
+    void DestroyProxy(int proxy);
+    // Updates the box of a proxy, returns true if it left its fat box and was inserted again
+    bool MoveProxy(int proxy, const Aabb &box);
+    void Clear();
+
+    const Aabb &GetBox(int proxy) const { return nodes[proxy].tight; }
+    const Aabb &GetFatBox(int proxy) const { return nodes[proxy].box; }
+    int GetUserData(int proxy) const { return nodes[proxy].userData; }
+    size_t GetProxyCount() const { return proxyCount; }
+    int GetHeight() const { return root == AABB_TREE_NULL ? 0 : nodes[root].height; }
+
+    // Calls callback(userData) for every proxy whose box overlaps area
+    template <typename TCallback> void QueryRectangle(const Aabb &area, TCallback callback) const;
+    // Calls callback(userData) for every proxy whose box is at most radius away from center
+    template <typename TCallback> void QueryRadius(glm::vec2 center, float radius, TCallback callback) const;
+    // Finds the first box hit by the ray, direction has to be normalized
+    bool Raycast(glm::vec2 origin, glm::vec2 direction, float maxDistance, RaycastHit &hit) const;
+};
+
+template <typename TCallback> void AabbTree::QueryRectangle(const Aabb &area, TCallback callback) const
+{
+    if (root == AABB_TREE_NULL)
+    {
+        return;
+    }
+
+    int stack[AABB_TREE_STACK_SIZE];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0)
+    {
+        const auto &node = nodes[stack[--count]];
+        if (!node.box.Overlaps(area))
+        {
+            continue;
+        }
+        if (node.IsLeaf())
+        {
+            if (node.tight.Overlaps(area))
+            {
+                callback(node.userData);
+            }
+            continue;
+        }
+        stack[count++] = node.child1;
+        stack[count++] = node.child2;
+    }
+}
+
+template <typename TCallback> void AabbTree::QueryRadius(glm::vec2 center, float radius, TCallback callback) const
+{
+    if (root == AABB_TREE_NULL)
+    {
+        return;
+    }
+
+    const auto radiusSquared = radius * radius;
+    int stack[AABB_TREE_STACK_SIZE];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0)
+    {
+        const auto &node = nodes[stack[--count]];
+        if (node.box.GetDistanceSquared(center) > radiusSquared)
+        {
+            continue;
+        }
+        if (node.IsLeaf())
+        {
+            if (node.tight.GetDistanceSquared(center) <= radiusSquared)
+            {
+                callback(node.userData);
+            }
+            continue;
+        }
+        stack[count++] = node.child1;
+        stack[count++] = node.child2;
+    }
+}
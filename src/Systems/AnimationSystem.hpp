@@ -3,6 +3,7 @@
 #include "../Components/AnimationComponent.hpp"
 #include "../Components/SpriteComponent.hpp"
 #include "../ECS/ECS.hpp"
+#include "../Profiler/Profiler.hpp"
 #include <SDL.h>
 
 class AnimationSystem : public System
@@ -16,10 +17,15 @@ class AnimationSystem : public System
 
     void Update()
     {
+        PROFILE_SCOPE("AnimationSystem::Update");
+
+        auto &animations = GetPool<AnimationComponent>();
+        auto &sprites = GetPool<SpriteComponent>();
+
         for (auto entity : GetSystemEntities())
         {
-            auto &animation = entity.GetComponent<AnimationComponent>();
-            auto &sprite = entity.GetComponent<SpriteComponent>();
+            auto &animation = animations.Get(entity.GetId());
+            auto &sprite = sprites.Get(entity.GetId());
 
             animation.currentFrame =
                 ((SDL_GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000) % animation.numFrames;
@@ -0,0 +1,324 @@
+#pragma once
+
+#include "../Components/BoxColliderComponent.hpp"
+#include "../Components/TranformComponent.hpp"
+#include "../ECS/ECS.hpp"
+#include "../EventBus/EventBus.hpp"
+#include "../Events/CollisionEvent.hpp"
+#include "../Memory/AllocationTracker.hpp"
+#include "../Profiler/Profiler.hpp"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define COLLISION_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// Two entities whose boxes overlap
+struct CollisionPair
+{
+    int first;
+    int second;
+};
+
+// The pairs of one update, they stay valid until the next update
+struct CollisionPairs
+{
+    const CollisionPair *data = nullptr;
+    size_t count = 0;
+
+    const CollisionPair *begin() const { return data; }
+    const CollisionPair *end() const { return data + count; }
+    size_t size() const { return count; }
+};
+
+// Edge length of the grid cells in pixels, a few times the size of a typical collider
+const float COLLISION_DEFAULT_CELL_SIZE = 64.0f;
+
+//////////////////////////////////////////////////////////////////////////////////
+// CollisionSystem
+//////////////////////////////////////////////////////////////////////////////////
+// Finds the overlapping boxes of all entities with a transform and a box
+// collider. The broadphase is a uniform grid over an unbounded world: every box
+// is entered into the cells it covers and only boxes sharing a cell are
+// compared. The cells are hashed into a table with a bucket or two per entry
+// and the entries are grouped by bucket with a counting sort, so the grid is
+// rebuilt every tick in linear time without touching the heap once the arrays
+// have grown to the peak.
+//
+// The narrowphase compares every two entries of a bucket, with one SSE
+// comparison per pair and a scalar fallback. A pair of boxes sharing several
+// cells is reported once, by the cell holding the top left corner of their
+// intersection. Boxes that only touch don't collide. The pairs are kept in a
+// buffer of the system that is reused by the next Update(), frames that run no
+// tick still see the pairs of the last one
+//////////////////////////////////////////////////////////////////////////////////
+class CollisionSystem : public System
+{
+  private:
+    // Flags of a grid entry, a pair is reported by the cell where both the
+    // column and the row are the first one of at least one of the two boxes
+    enum EntryFlags : int32_t
+    {
+        ENTRY_FIRST_COLUMN = 1 << 0,
+        ENTRY_FIRST_ROW = 1 << 1,
+        ENTRY_REPORTS_PAIR = ENTRY_FIRST_COLUMN | ENTRY_FIRST_ROW,
+    };
+
+    // A box entered into one grid cell. The box is stored as (minX, minY,
+    // -maxX, -maxY): two boxes overlap if every lane of one is less than the
+    // matching lane of (maxX, maxY, -minX, -minY) of the other, that is one
+    // SSE comparison. Half a cache line, so placing it touches a single line
+    struct alignas(16) GridEntry
+    {
+        float box[4];
+        int id;
+        // The cell of the entry, entries of different cells can share a bucket
+        int32_t cell;
+        int32_t flags;
+    };
+
+    float cellSize = COLLISION_DEFAULT_CELL_SIZE;
+
+    // Boxes in the order of the system's entities, and the range of cells they cover
+    std::vector<int> boxIds;
+    std::vector<float> boxMinX;
+    std::vector<float> boxMaxX;
+    std::vector<float> boxMinY;
+    std::vector<float> boxMaxY;
+    std::vector<int32_t> boxCells;
+
+    // Grid entries grouped by bucket, bucket b holds [bucketStarts[b], bucketStarts[b + 1])
+    std::vector<uint32_t> bucketStarts;
+    // Bucket of every entry in the order of the boxes, so the cells are only hashed once
+    std::vector<uint32_t> entryBuckets;
+    std::vector<GridEntry> entries;
+
+    std::vector<CollisionPair> pairs;
+
+    bool useSimd = true;
+
+    // Cells are identified by their column and row packed into 16 bits each.
+    // Cells 65536 columns or rows apart share an id, that only matters for
+    // boxes millions of pixels across
+    static int32_t GetCellId(int column, int row)
+    {
+        return static_cast<int32_t>((static_cast<uint32_t>(column) & 0xFFFF) | (static_cast<uint32_t>(row) << 16));
+    }
+
+    static uint32_t GetBucket(int32_t cell, uint32_t bucketMask)
+    {
+        // Multiplicative hash, the high bits are the well mixed ones
+        const auto hash = static_cast<uint64_t>(static_cast<uint32_t>(cell)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint32_t>(hash >> 32) & bucketMask;
+    }
+
+    void ComputeBoxes()
+    {
+        const auto &transforms = GetPool<TransformComponent>();
+        const auto &colliders = GetPool<BoxColliderComponent>();
+        const auto &entities = GetSystemEntities();
+        const auto count = entities.size();
+
+        boxIds.resize(count);
+        boxMinX.resize(count);
+        boxMaxX.resize(count);
+        boxMinY.resize(count);
+        boxMaxY.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto id = entities[i].GetId();
+            const auto &transform = transforms.Get(id);
+            const auto &collider = colliders.Get(id);
+            boxIds[i] = id;
+            boxMinX[i] = transform.position.x + collider.offset.x;
+            boxMinY[i] = transform.position.y + collider.offset.y;
+            boxMaxX[i] = boxMinX[i] + collider.width * transform.scale.x;
+            boxMaxY[i] = boxMinY[i] + collider.height * transform.scale.y;
+        }
+    }
+
+    // Fills the grid entries, grouped by bucket
+    void BuildGrid()
+    {
+        const auto count = boxIds.size();
+        const auto inverseCellSize = 1.0f / cellSize;
+
+        // First, last column, first, last row of every box
+        boxCells.resize(count * 4);
+        size_t entryCount = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            auto *cells = &boxCells[i * 4];
+            cells[0] = static_cast<int32_t>(std::floor(boxMinX[i] * inverseCellSize));
+            cells[1] = static_cast<int32_t>(std::floor(boxMaxX[i] * inverseCellSize));
+            cells[2] = static_cast<int32_t>(std::floor(boxMinY[i] * inverseCellSize));
+            cells[3] = static_cast<int32_t>(std::floor(boxMaxY[i] * inverseCellSize));
+            entryCount += static_cast<size_t>(cells[1] - cells[0] + 1) * (cells[3] - cells[2] + 1);
+        }
+
+        // At least one bucket per entry, a power of two so the bucket is a mask away
+        size_t bucketCount = 16;
+        while (bucketCount < entryCount)
+        {
+            bucketCount *= 2;
+        }
+        const auto bucketMask = static_cast<uint32_t>(bucketCount - 1);
+
+        // Counting sort: count the entries of every bucket, turn the counts into
+        // start offsets and place the entries
+        bucketStarts.assign(bucketCount + 1, 0);
+        entryBuckets.resize(entryCount);
+        size_t entry = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto *cells = &boxCells[i * 4];
+            for (auto row = cells[2]; row <= cells[3]; row++)
+            {
+                for (auto column = cells[0]; column <= cells[1]; column++)
+                {
+                    const auto bucket = GetBucket(GetCellId(column, row), bucketMask);
+                    entryBuckets[entry++] = bucket;
+                    bucketStarts[bucket + 1]++;
+                }
+            }
+        }
+        for (size_t bucket = 0; bucket < bucketCount; bucket++)
+        {
+            bucketStarts[bucket + 1] += bucketStarts[bucket];
+        }
+
+        entries.resize(entryCount);
+        entry = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const auto *cells = &boxCells[i * 4];
+            for (auto row = cells[2]; row <= cells[3]; row++)
+            {
+                for (auto column = cells[0]; column <= cells[1]; column++)
+                {
+                    // bucketStarts[b] walks through the bucket and ends up at the start of bucket b + 1
+                    auto &gridEntry = entries[bucketStarts[entryBuckets[entry++]]++];
+                    gridEntry.box[0] = boxMinX[i];
+                    gridEntry.box[1] = boxMinY[i];
+                    gridEntry.box[2] = -boxMaxX[i];
+                    gridEntry.box[3] = -boxMaxY[i];
+                    gridEntry.id = boxIds[i];
+                    gridEntry.cell = GetCellId(column, row);
+                    gridEntry.flags =
+                        (column == cells[0] ? ENTRY_FIRST_COLUMN : 0) | (row == cells[2] ? ENTRY_FIRST_ROW : 0);
+                }
+            }
+        }
+        // Shift the offsets back, bucket b starts where bucket b - 1 ended
+        for (size_t bucket = bucketCount; bucket > 0; bucket--)
+        {
+            bucketStarts[bucket] = bucketStarts[bucket - 1];
+        }
+        bucketStarts[0] = 0;
+    }
+
+    void AddPair(int first, int second) { pairs.push_back({first, second}); }
+
+    static bool ReportsPair(const GridEntry &a, const GridEntry &b)
+    {
+        return a.cell == b.cell && (a.flags | b.flags) == ENTRY_REPORTS_PAIR;
+    }
+
+    void TestBucketScalar(size_t begin, size_t end)
+    {
+        for (auto i = begin; i + 1 < end; i++)
+        {
+            const auto &a = entries[i];
+            for (auto j = i + 1; j < end; j++)
+            {
+                const auto &b = entries[j];
+                if (b.box[0] < -a.box[2] && b.box[1] < -a.box[3] && a.box[0] < -b.box[2] && a.box[1] < -b.box[3] &&
+                    ReportsPair(a, b))
+                {
+                    AddPair(a.id, b.id);
+                }
+            }
+        }
+    }
+
+#ifdef COLLISION_SSE
+    void TestBucketSse(size_t begin, size_t end)
+    {
+        for (auto i = begin; i + 1 < end; i++)
+        {
+            const auto &a = entries[i];
+            // (maxX, maxY, -minX, -minY) of a
+            const auto box = _mm_load_ps(a.box);
+            const auto limits = _mm_shuffle_ps(_mm_sub_ps(_mm_setzero_ps(), box), _mm_sub_ps(_mm_setzero_ps(), box),
+                                               _MM_SHUFFLE(1, 0, 3, 2));
+            for (auto j = i + 1; j < end; j++)
+            {
+                const auto &b = entries[j];
+                if (_mm_movemask_ps(_mm_cmplt_ps(_mm_load_ps(b.box), limits)) == 0xF && ReportsPair(a, b))
+                {
+                    AddPair(a.id, b.id);
+                }
+            }
+        }
+    }
+#endif
+
+  public:
+    CollisionSystem()
+    {
+        RequireComponent<TransformComponent>();
+        RequireComponent<BoxColliderComponent>();
+    }
+
+    void SetCellSize(float size) { cellSize = size; }
+
+    // Only has an effect when the SSE narrowphase is compiled in, for comparing the two
+    void SetSimd(bool enabled) { useSimd = enabled; }
+
+    // Finds the overlapping boxes. A CollisionEvent per pair is queued on the
+    // event bus if anyone listens
+    void Update(EventBus &eventBus)
+    {
+        PROFILE_SCOPE("CollisionSystem::Update");
+        ALLOCATION_SCOPE(ALLOC_PHYSICS);
+
+        ComputeBoxes();
+        BuildGrid();
+
+        // Keeps its capacity, so the buffer only grows when there are more pairs than ever before
+        pairs.clear();
+
+        const auto bucketCount = bucketStarts.size() - 1;
+        for (size_t bucket = 0; bucket < bucketCount; bucket++)
+        {
+            const auto begin = bucketStarts[bucket];
+            const auto end = bucketStarts[bucket + 1];
+            if (end - begin < 2)
+            {
+                continue;
+            }
+#ifdef COLLISION_SSE
+            if (useSimd)
+            {
+                TestBucketSse(begin, end);
+                continue;
+            }
+#endif
+            TestBucketScalar(begin, end);
+        }
+
+        if (eventBus.HasSubscribers<CollisionEvent>())
+        {
+            for (const auto &pair : GetCollisions())
+            {
+                eventBus.Emit<CollisionEvent>(pair.first, pair.second);
+            }
+        }
+    }
+
+    // The overlapping pairs found by the last Update()
+    CollisionPairs GetCollisions() const { return {pairs.data(), pairs.size()}; }
+};
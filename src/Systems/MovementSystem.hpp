@@ -3,6 +3,7 @@
 #include "../Components/RigidBodyComponent.hpp"
 #include "../Components/TranformComponent.hpp"
 #include "../ECS/ECS.hpp"
+#include "../Profiler/Profiler.hpp"
 
 class MovementSystem : public System
 {
@@ -15,20 +16,26 @@ class MovementSystem : public System
 
     void Update(double deltaTime)
     {
+        PROFILE_SCOPE("MovementSystem::Update");
+
+        auto &transforms = GetPool<TransformComponent>();
+        const auto &rigidbodies = GetPool<RigidBodyComponent>();
+
         // Loop all entities that the system is interested in
         for (auto entity : GetSystemEntities())
         {
             // Update entity position based on its velocity
-            auto &transform = entity.GetComponent<TransformComponent>();
-            const auto &rigidbody = entity.GetComponent<RigidBodyComponent>();
+            auto &transform = transforms.Get(entity.GetId());
+            const auto &rigidbody = rigidbodies.Get(entity.GetId());
+
+            transform.previousPosition = transform.position;
+            transform.previousRotation = transform.rotation;
 
             transform.position.x += rigidbody.velocity.x * deltaTime;
             transform.position.y += rigidbody.velocity.y * deltaTime;
 
-            // Logger::Log("Entity id = " + std::to_string(entity.GetId()) +
-            //             " positition is now (" +
-            //             std::to_string(transform.position.x) + ", " +
-            //             std::to_string(transform.position.y) + ")");
+            // LOGGER_LOG("Entity id = {} positition is now ({}, {})", entity.GetId(), transform.position.x,
+            //            transform.position.y);
         }
     }
 };
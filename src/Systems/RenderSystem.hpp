@@ -4,10 +4,20 @@
 #include "../Components/SpriteComponent.hpp"
 #include "../Components/TranformComponent.hpp"
 #include "../ECS/ECS.hpp"
+#include "../Memory/AllocationTracker.hpp"
+#include "../Profiler/Profiler.hpp"
+#include "SpatialSystem.hpp"
 #include <SDL.h>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <memory_resource>
+#include <vector>
 
 class RenderSystem : public System
 {
+  private:
+    int drawCalls = 0;
+
   public:
     RenderSystem()
     {
@@ -15,43 +25,98 @@ class RenderSystem : public System
         RequireComponent<SpriteComponent>();
     }
 
-    void Update(SDL_Renderer *renderer, std::unique_ptr<AssetStore> &assetStore)
+    // alpha is how far we are between the previous and the current simulation
+    // tick (0..1), used to interpolate the transforms. Scratch data is
+    // allocated from frameMemory (the frame arena)
+    void Update(SDL_Renderer *renderer, std::unique_ptr<AssetStore> &assetStore, double alpha,
+                std::pmr::memory_resource *frameMemory)
     {
-        // Create a vector with both Sprite and Transform component of all entities
+        PROFILE_SCOPE("RenderSystem::Update");
+        ALLOCATION_SCOPE(ALLOC_RENDER);
+
+        drawCalls = 0;
+
+        // Create a vector pointing to both Sprite and Transform component of all
+        // entities, the components themselves are not copied
         struct RenderableEntity
         {
-            TransformComponent transformComponent;
-            SpriteComponent SpriteComponent;
+            const TransformComponent *transformComponent;
+            const SpriteComponent *spriteComponent;
+            int entityId;
         };
-        std::vector<RenderableEntity> renderableEntities;
-        for (auto entity : GetSystemEntities())
+        auto &sprites = GetPool<SpriteComponent>();
+        auto &transforms = GetPool<TransformComponent>();
+
+        std::pmr::vector<RenderableEntity> renderableEntities(frameMemory);
+        renderableEntities.reserve(GetSystemEntities().size());
+        const auto addRenderable = [&](int entityId)
+        { renderableEntities.push_back({&transforms.Get(entityId), &sprites.Get(entityId), entityId}); };
+
+        // The tree is filled by SpatialSystem::Update(), until that has run every sprite is drawn
+        const AabbTree *tree = nullptr;
+        if (registry->HasSystem<SpatialSystem>())
         {
-            RenderableEntity renderableEntity;
-            renderableEntity.SpriteComponent = entity.GetComponent<SpriteComponent>();
-            renderableEntity.transformComponent = entity.GetComponent<TransformComponent>();
-            renderableEntities.emplace_back(renderableEntity);
+            tree = &registry->GetSystem<SpatialSystem>().GetTree();
+        }
+        if (tree && tree->GetProxyCount() > 0)
+        {
+            // Only the sprites that are on screen, the spatial boxes cover the
+            // sprites at both ticks the position is interpolated between
+            int width, height;
+            SDL_GetRendererOutputSize(renderer, &width, &height);
+            const Aabb screen = {glm::vec2(0, 0), glm::vec2(width, height)};
+            tree->QueryRectangle(screen,
+                                 [&](int entityId)
+                                 {
+                                     if (sprites.Has(entityId))
+                                     {
+                                         addRenderable(entityId);
+                                     }
+                                 });
+        }
+        else
+        {
+            for (auto entity : GetSystemEntities())
+            {
+                addRenderable(entity.GetId());
+            }
         }
 
+        // The id keeps sprites on the same layer in a stable order, the tree returns them in any order
         std::sort(renderableEntities.begin(), renderableEntities.end(),
                   [](const RenderableEntity &a, const RenderableEntity &b)
-                  { return a.SpriteComponent.zIndex < b.SpriteComponent.zIndex; });
+                  {
+                      if (a.spriteComponent->zIndex != b.spriteComponent->zIndex)
+                      {
+                          return a.spriteComponent->zIndex < b.spriteComponent->zIndex;
+                      }
+                      return a.entityId < b.entityId;
+                  });
 
         // Loop all entities that the system is interested in
-        for (auto entity : renderableEntities)
+        for (const auto &entity : renderableEntities)
         {
-            const auto transform = entity.transformComponent;
-            const auto sprite = entity.SpriteComponent;
+            const auto &transform = *entity.transformComponent;
+            const auto &sprite = *entity.spriteComponent;
+
+            const auto position = glm::mix(transform.previousPosition, transform.position, static_cast<float>(alpha));
+            const auto rotation =
+                transform.previousRotation + (transform.rotation - transform.previousRotation) * alpha;
 
             // Set the source rectangle at our original sprite texture
             SDL_Rect srcRect = sprite.srcRect;
 
             // Set the destination rectangle with the x,y position to be rendered
-            SDL_Rect dstRect = {static_cast<int>(transform.position.x), static_cast<int>(transform.position.y),
+            SDL_Rect dstRect = {static_cast<int>(position.x), static_cast<int>(position.y),
                                 static_cast<int>(sprite.width * transform.scale.x),
                                 static_cast<int>(sprite.height * transform.scale.y)};
 
-            SDL_RenderCopyEx(renderer, assetStore->GetTexture(sprite.assetId), &srcRect, &dstRect, transform.rotation,
-                             NULL, SDL_FLIP_NONE);
+            SDL_RenderCopyEx(renderer, assetStore->GetTexture(sprite.assetId), &srcRect, &dstRect, rotation, NULL,
+                             SDL_FLIP_NONE);
+            drawCalls++;
         }
     }
+
+    // Number of sprites submitted to the renderer by the last Update()
+    int GetDrawCallCount() const { return drawCalls; }
 };
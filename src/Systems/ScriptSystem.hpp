@@ -0,0 +1,537 @@
+#pragma once
+
+#include "../Components/RigidBodyComponent.hpp"
+#include "../Components/ScriptComponent.hpp"
+#include "../Components/TranformComponent.hpp"
+#include "../ECS/ECS.hpp"
+#include "../EventBus/EventBus.hpp"
+#include "../Events/CollisionEvent.hpp"
+#include "../Input/Input.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Memory/AllocationTracker.hpp"
+#include "../Profiler/Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <sol/sol.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// CPU time spent in one behavior (or in the coroutines) during the last update
+struct ScriptStats
+{
+    const char *name;
+    size_t entities;
+    double milliseconds;
+};
+
+//////////////////////////////////////////////////////////////////////////////////
+// ScriptSystem
+//////////////////////////////////////////////////////////////////////////////////
+// Runs the Lua behaviors of entities with a script, transform and rigid body
+// component. Behaviors are registered from Lua:
+//
+//     register_behavior("patrol", {
+//         update = function(batch, dt)
+//             for i = 1, batch.count do
+//                 batch.vx[i] = -batch.vx[i]
+//             end
+//         end
+//     })
+//
+// update() is called once per tick with all entities of the behavior instead of
+// once per entity. The batch holds the arrays ids, x, y, vx and vy, the tables
+// are reused every tick and the positions and velocities are copied back into
+// the components after the call.
+//
+// start_coroutine(f) runs f as a coroutine scheduled by the system, calling
+// wait(seconds) inside it suspends it for that much simulation time.
+//
+// Behaviors live in their own files loaded with load_script(path), these are
+// run again when the file changes: registering the behaviors again swaps their
+// update functions while the entities and their components stay untouched, the
+// coroutines and file watches the script started before are dropped first.
+// watch_file(path, f) calls f whenever the file changes, e.g. to respawn a
+// tilemap. Changes are reported by the game through OnFileChanged().
+//
+// on_collision(f) calls f once per dispatch of the event bus with all the
+// CollisionEvents of the tick, batch.first and batch.second hold the entity
+// ids of the pairs. The system only subscribes to the events while there are
+// such callbacks, so the collision system emits none otherwise.
+//
+// find_action(name) returns the id of an input action ("move_up", "fire", ...
+// see Input), look it up once when the script loads. action_down(id),
+// action_pressed(id) and action_released(id) query the actions of the current
+// tick with that id
+//////////////////////////////////////////////////////////////////////////////////
+class ScriptSystem : public System
+{
+  private:
+    struct Behavior
+    {
+        std::string name;
+        sol::protected_function update;
+        sol::table batch;
+        sol::table ids;
+        sol::table x;
+        sol::table y;
+        sol::table vx;
+        sol::table vy;
+        // Entities of this behavior in the current update
+        std::vector<Entity> entities;
+        double milliseconds = 0.0;
+        // Set when update() raised an error, the behavior is skipped until it is registered again
+        bool failed = false;
+    };
+
+    struct ScheduledCoroutine
+    {
+        sol::thread thread;
+        sol::coroutine coroutine;
+        // Simulation time at which the coroutine is resumed next
+        double wakeTime;
+        // Script file that started the coroutine while being loaded, empty if it was started later
+        std::string owner;
+    };
+
+    struct FileWatch
+    {
+        std::string path;
+        sol::protected_function callback;
+        std::string owner;
+    };
+
+    struct CollisionCallback
+    {
+        sol::protected_function callback;
+        std::string owner;
+    };
+
+    sol::state &lua;
+    EventBus &eventBus;
+    const Input &input;
+
+    // A deque so the names stay put, the profiler keeps pointers to them
+    std::deque<Behavior> behaviors;
+    std::unordered_map<std::string, int> behaviorIndices;
+
+    std::vector<ScheduledCoroutine> coroutines;
+    // Coroutines started since the last update, they may be started from
+    // inside another coroutine while the list is being walked
+    std::vector<ScheduledCoroutine> startedCoroutines;
+    double coroutineMilliseconds = 0.0;
+
+    std::vector<FileWatch> fileWatches;
+    // Files loaded with load_script(), reloaded when they change
+    std::vector<std::string> scriptFiles;
+    // Script file that is being run by LoadScript()
+    std::string loadingScript;
+
+    std::vector<CollisionCallback> collisionCallbacks;
+    bool isSubscribedToCollisions = false;
+    sol::table collisionBatch;
+    sol::table collisionFirst;
+    sol::table collisionSecond;
+
+    // Simulation time in seconds
+    double time = 0.0;
+
+    std::vector<ScriptStats> stats;
+
+    // Writes value(i) for i in [0, count) to the array part of table
+    template <typename TValue> static void WriteNumbers(const sol::table &table, size_t count, TValue value)
+    {
+        lua_State *state = table.lua_state();
+        table.push();
+        for (size_t i = 0; i < count; i++)
+        {
+            lua_pushnumber(state, static_cast<lua_Number>(value(i)));
+            lua_rawseti(state, -2, static_cast<lua_Integer>(i + 1));
+        }
+        lua_pop(state, 1);
+    }
+
+    // Calls store(i, number) for the first count elements of the table
+    template <typename TStore> static void ReadNumbers(const sol::table &table, size_t count, TStore store)
+    {
+        lua_State *state = table.lua_state();
+        table.push();
+        for (size_t i = 0; i < count; i++)
+        {
+            lua_rawgeti(state, -1, static_cast<lua_Integer>(i + 1));
+            store(i, lua_tonumber(state, -1));
+            lua_pop(state, 1);
+        }
+        lua_pop(state, 1);
+    }
+
+    void RegisterBehavior(const std::string &name, const sol::table &definition)
+    {
+        sol::optional<sol::protected_function> update = definition["update"];
+        if (!update)
+        {
+            LOGGER_ERR("Behavior {} has no update function", name);
+            return;
+        }
+
+        auto found = behaviorIndices.find(name);
+        if (found == behaviorIndices.end())
+        {
+            auto &behavior = behaviors.emplace_back();
+            behavior.name = name;
+            behavior.ids = lua.create_table();
+            behavior.x = lua.create_table();
+            behavior.y = lua.create_table();
+            behavior.vx = lua.create_table();
+            behavior.vy = lua.create_table();
+            behavior.batch = lua.create_table_with("count", 0, "ids", behavior.ids, "x", behavior.x, "y", behavior.y,
+                                                   "vx", behavior.vx, "vy", behavior.vy);
+            found = behaviorIndices.emplace(name, static_cast<int>(behaviors.size() - 1)).first;
+        }
+
+        // Registering a behavior again replaces its update function
+        auto &behavior = behaviors[found->second];
+        behavior.update = *update;
+        behavior.failed = false;
+    }
+
+    void StartCoroutine(const sol::function &function)
+    {
+        // Every coroutine runs on its own Lua thread
+        sol::thread thread = sol::thread::create(lua.lua_state());
+        sol::coroutine coroutine(thread.state(), function);
+        startedCoroutines.push_back({std::move(thread), std::move(coroutine), time, loadingScript});
+    }
+
+    void WatchFile(const std::string &path, const sol::protected_function &callback)
+    {
+        fileWatches.push_back({path, callback, loadingScript});
+    }
+
+    // The bit of the action in mask, ids find_action() can't have returned read as not set
+    static bool HasAction(ActionMask mask, int action)
+    {
+        return action >= 0 && action < ACTION_COUNT && ((mask >> action) & 1);
+    }
+
+    void OnCollision(const sol::protected_function &callback)
+    {
+        collisionCallbacks.push_back({callback, loadingScript});
+        UpdateCollisionSubscription();
+    }
+
+    void UpdateCollisionSubscription()
+    {
+        const auto wantsCollisions = !collisionCallbacks.empty();
+        if (wantsCollisions == isSubscribedToCollisions)
+        {
+            return;
+        }
+        if (wantsCollisions)
+        {
+            eventBus.Subscribe<CollisionEvent, &ScriptSystem::OnCollisions>(this);
+        }
+        else
+        {
+            eventBus.Unsubscribe<CollisionEvent, &ScriptSystem::OnCollisions>(this);
+        }
+        isSubscribedToCollisions = wantsCollisions;
+    }
+
+    // Drops what a script set up while it was loaded, before it runs again
+    void ForgetScript(const std::string &path)
+    {
+        const auto ownedBy = [&](const auto &item) { return item.owner == path; };
+        coroutines.erase(std::remove_if(coroutines.begin(), coroutines.end(), ownedBy), coroutines.end());
+        startedCoroutines.erase(std::remove_if(startedCoroutines.begin(), startedCoroutines.end(), ownedBy),
+                                startedCoroutines.end());
+        fileWatches.erase(std::remove_if(fileWatches.begin(), fileWatches.end(), ownedBy), fileWatches.end());
+        collisionCallbacks.erase(std::remove_if(collisionCallbacks.begin(), collisionCallbacks.end(), ownedBy),
+                                 collisionCallbacks.end());
+        UpdateCollisionSubscription();
+    }
+
+    void RunBehavior(Behavior &behavior, double deltaTime)
+    {
+        PROFILE_SCOPE(behavior.name.c_str());
+
+        auto &transforms = GetPool<TransformComponent>();
+        auto &rigidbodies = GetPool<RigidBodyComponent>();
+        const auto &entities = behavior.entities;
+        const auto count = entities.size();
+
+        WriteNumbers(behavior.ids, count, [&](size_t i) { return entities[i].GetId(); });
+        WriteNumbers(behavior.x, count, [&](size_t i) { return transforms.Get(entities[i].GetId()).position.x; });
+        WriteNumbers(behavior.y, count, [&](size_t i) { return transforms.Get(entities[i].GetId()).position.y; });
+        WriteNumbers(behavior.vx, count, [&](size_t i) { return rigidbodies.Get(entities[i].GetId()).velocity.x; });
+        WriteNumbers(behavior.vy, count, [&](size_t i) { return rigidbodies.Get(entities[i].GetId()).velocity.y; });
+        behavior.batch["count"] = count;
+
+        sol::protected_function_result result = behavior.update(behavior.batch, deltaTime);
+        if (!result.valid())
+        {
+            sol::error error = result;
+            LOGGER_ERR("Behavior {} failed and is disabled: {}", behavior.name, error.what());
+            behavior.failed = true;
+            return;
+        }
+
+        ReadNumbers(behavior.x, count,
+                    [&](size_t i, lua_Number value) { transforms.Get(entities[i].GetId()).position.x = value; });
+        ReadNumbers(behavior.y, count,
+                    [&](size_t i, lua_Number value) { transforms.Get(entities[i].GetId()).position.y = value; });
+        ReadNumbers(behavior.vx, count,
+                    [&](size_t i, lua_Number value) { rigidbodies.Get(entities[i].GetId()).velocity.x = value; });
+        ReadNumbers(behavior.vy, count,
+                    [&](size_t i, lua_Number value) { rigidbodies.Get(entities[i].GetId()).velocity.y = value; });
+    }
+
+    void ResumeCoroutines()
+    {
+        PROFILE_SCOPE("ScriptSystem::ResumeCoroutines");
+
+        for (auto &started : startedCoroutines)
+        {
+            coroutines.push_back(std::move(started));
+        }
+        startedCoroutines.clear();
+
+        for (size_t i = 0; i < coroutines.size();)
+        {
+            auto &scheduled = coroutines[i];
+            if (scheduled.wakeTime > time)
+            {
+                i++;
+                continue;
+            }
+
+            sol::protected_function_result result = scheduled.coroutine();
+            if (result.valid() && result.status() == sol::call_status::yielded)
+            {
+                // wait() yields the number of seconds to sleep
+                const auto seconds = result.get<sol::optional<double>>();
+                scheduled.wakeTime = time + seconds.value_or(0.0);
+                i++;
+                continue;
+            }
+            if (!result.valid())
+            {
+                sol::error error = result;
+                LOGGER_ERR("Coroutine failed: {}", error.what());
+            }
+
+            // Finished or failed, the order of the coroutines does not matter
+            if (i + 1 < coroutines.size())
+            {
+                coroutines[i] = std::move(coroutines.back());
+            }
+            coroutines.pop_back();
+        }
+    }
+
+  public:
+    ScriptSystem(sol::state &lua, EventBus &eventBus, const Input &input) : lua(lua), eventBus(eventBus), input(input)
+    {
+        RequireComponent<ScriptComponent>();
+        RequireComponent<TransformComponent>();
+        RequireComponent<RigidBodyComponent>();
+
+        // The functions keep a pointer to the system, it has to outlive the Lua state's use of them
+        lua.set_function("register_behavior", [this](const std::string &name, const sol::table &definition)
+                         { RegisterBehavior(name, definition); });
+        lua.set_function("start_coroutine", [this](const sol::function &function) { StartCoroutine(function); });
+        lua.set_function("wait", sol::yielding([](sol::optional<double> seconds) { return seconds.value_or(0.0); }));
+        lua.set_function("load_script", [this](const std::string &path) { return LoadScript(path); });
+        lua.set_function("watch_file", [this](const std::string &path, const sol::protected_function &callback)
+                         { WatchFile(path, callback); });
+        lua.set_function("on_collision", [this](const sol::protected_function &callback) { OnCollision(callback); });
+        lua.set_function("find_action",
+                         [](const std::string &name) -> sol::optional<int>
+                         {
+                             const auto action = Input::FindAction(name);
+                             if (action == ACTION_COUNT)
+                             {
+                                 LOGGER_ERR("Unknown input action {}", name);
+                                 return sol::nullopt;
+                             }
+                             return static_cast<int>(action);
+                         });
+        lua.set_function("action_down",
+                         [this](int action) { return HasAction(this->input.GetTickActions().down, action); });
+        lua.set_function("action_pressed",
+                         [this](int action) { return HasAction(this->input.GetTickActions().pressed, action); });
+        lua.set_function("action_released",
+                         [this](int action) { return HasAction(this->input.GetTickActions().released, action); });
+
+        collisionFirst = lua.create_table();
+        collisionSecond = lua.create_table();
+        collisionBatch = lua.create_table_with("count", 0, "first", collisionFirst, "second", collisionSecond);
+    }
+
+    ~ScriptSystem()
+    {
+        if (isSubscribedToCollisions)
+        {
+            eventBus.Unsubscribe<CollisionEvent, &ScriptSystem::OnCollisions>(this);
+        }
+    }
+
+    // Hands the collisions of the tick to the on_collision() callbacks in one batch
+    void OnCollisions(const CollisionEvent *events, size_t count)
+    {
+        PROFILE_FUNCTION();
+        ALLOCATION_SCOPE(ALLOC_SCRIPTS);
+
+        WriteNumbers(collisionFirst, count, [&](size_t i) { return events[i].first; });
+        WriteNumbers(collisionSecond, count, [&](size_t i) { return events[i].second; });
+        collisionBatch["count"] = count;
+
+        // By index, a callback may register more callbacks
+        const auto callbackCount = collisionCallbacks.size();
+        for (size_t i = 0; i < callbackCount && i < collisionCallbacks.size(); i++)
+        {
+            const auto callback = collisionCallbacks[i].callback;
+            sol::protected_function_result result = callback(collisionBatch);
+            if (!result.valid())
+            {
+                sol::error error = result;
+                LOGGER_ERR("Collision callback failed: {}", error.what());
+            }
+        }
+    }
+
+    // Runs a behavior script and remembers it for reloading, returns false if it failed
+    bool LoadScript(const std::string &path)
+    {
+        PROFILE_FUNCTION();
+        ALLOCATION_SCOPE(ALLOC_SCRIPTS);
+
+        if (std::find(scriptFiles.begin(), scriptFiles.end(), path) == scriptFiles.end())
+        {
+            scriptFiles.push_back(path);
+        }
+
+        // Scripts may load other scripts
+        auto previousScript = std::move(loadingScript);
+        loadingScript = path;
+        sol::protected_function_result result = lua.safe_script_file(path, sol::script_pass_on_error);
+        loadingScript = std::move(previousScript);
+
+        if (!result.valid())
+        {
+            sol::error error = result;
+            LOGGER_ERR("Error running script {}: {}", path, error.what());
+            return false;
+        }
+        return true;
+    }
+
+    // Reloads the script file and calls the watch_file() callbacks of the file,
+    // returns false if no script is interested in it
+    bool OnFileChanged(const std::string &path)
+    {
+        PROFILE_FUNCTION();
+        ALLOCATION_SCOPE(ALLOC_SCRIPTS);
+
+        auto handled = false;
+        if (std::find(scriptFiles.begin(), scriptFiles.end(), path) != scriptFiles.end())
+        {
+            ForgetScript(path);
+            // On errors the behaviors keep their previous update functions
+            LoadScript(path);
+            handled = true;
+        }
+
+        // Callbacks may watch more files, walk a copy
+        const auto watches = fileWatches;
+        for (const auto &watch : watches)
+        {
+            if (watch.path != path)
+            {
+                continue;
+            }
+            sol::protected_function_result result = watch.callback();
+            if (!result.valid())
+            {
+                sol::error error = result;
+                LOGGER_ERR("File watch callback of {} failed: {}", path, error.what());
+            }
+            handled = true;
+        }
+
+        if (handled)
+        {
+            // The scripts may register behaviors that were unknown so far, look
+            // them up again on the next update
+            auto &scripts = GetPool<ScriptComponent>();
+            for (auto entity : GetSystemEntities())
+            {
+                auto &script = scripts.Get(entity.GetId());
+                if (script.behaviorIndex == -2)
+                {
+                    script.behaviorIndex = -1;
+                }
+            }
+        }
+        return handled;
+    }
+
+    void Update(double deltaTime)
+    {
+        PROFILE_SCOPE("ScriptSystem::Update");
+        ALLOCATION_SCOPE(ALLOC_SCRIPTS);
+
+        // Sort the entities into one batch per behavior
+        auto &scripts = GetPool<ScriptComponent>();
+        for (auto &behavior : behaviors)
+        {
+            behavior.entities.clear();
+        }
+        for (auto entity : GetSystemEntities())
+        {
+            auto &script = scripts.Get(entity.GetId());
+            if (script.behaviorIndex == -1)
+            {
+                const auto found = behaviorIndices.find(script.behavior);
+                if (found == behaviorIndices.end())
+                {
+                    // Reported once, the entity is ignored until a script file changes
+                    LOGGER_WARN("Entity {} uses the unknown behavior {}", entity.GetId(), script.behavior);
+                    script.behaviorIndex = -2;
+                    continue;
+                }
+                script.behaviorIndex = found->second;
+            }
+            if (script.behaviorIndex >= 0)
+            {
+                behaviors[script.behaviorIndex].entities.push_back(entity);
+            }
+        }
+
+        stats.clear();
+        for (auto &behavior : behaviors)
+        {
+            behavior.milliseconds = 0.0;
+            if (!behavior.entities.empty() && !behavior.failed)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                RunBehavior(behavior, deltaTime);
+                behavior.milliseconds =
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            stats.push_back({behavior.name.c_str(), behavior.entities.size(), behavior.milliseconds});
+        }
+
+        time += deltaTime;
+        const auto start = std::chrono::steady_clock::now();
+        ResumeCoroutines();
+        coroutineMilliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.push_back({"coroutines", coroutines.size(), coroutineMilliseconds});
+    }
+
+    // Per behavior CPU time of the last update, the coroutines are the last entry
+    const std::vector<ScriptStats> &GetStats() const { return stats; }
+};
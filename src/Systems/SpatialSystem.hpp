@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../Components/BoxColliderComponent.hpp"
+#include "../Components/SpriteComponent.hpp"
+#include "../Components/TranformComponent.hpp"
+#include "../ECS/ECS.hpp"
+#include "../Memory/AllocationTracker.hpp"
+#include "../Profiler/Profiler.hpp"
+#include "../Spatial/AabbTree.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////
+// SpatialSystem
+//////////////////////////////////////////////////////////////////////////////////
+// Keeps every entity with a transform in an AabbTree, the user data of the
+// proxies are the entity ids. The box of an entity covers its sprite and its
+// box collider at both the previous and the current position, so it also holds
+// everything the renderer may draw between two ticks. Entities with neither are
+// a point at their position. Used for render culling and for gameplay queries
+// (entities in a radius, raycasts, rectangle selection):
+//
+//     registry->GetSystem<SpatialSystem>().GetTree().QueryRadius(center, 100.0f,
+//         [&](int entityId) { ... });
+//////////////////////////////////////////////////////////////////////////////////
+class SpatialSystem : public System
+{
+  private:
+    AabbTree tree;
+    // Entity id -> proxy in the tree, AABB_TREE_NULL if it has none
+    std::vector<int> proxies;
+    // Entities with a proxy, and the update that last saw each of them in the system
+    std::vector<int> trackedEntities;
+    std::vector<uint32_t> lastSeen;
+    uint32_t updateCount = 0;
+    // Proxies that left their fat box in the last update
+    size_t reinsertions = 0;
+
+    Aabb ComputeBox(int id, const Pool<TransformComponent> &transforms, const Pool<SpriteComponent> &sprites,
+                    const Pool<BoxColliderComponent> &colliders) const
+    {
+        const auto &transform = transforms.Get(id);
+        const auto low = glm::min(transform.previousPosition, transform.position);
+        const auto high = glm::max(transform.previousPosition, transform.position);
+
+        Aabb box = {low, high};
+        if (sprites.Has(id))
+        {
+            const auto &sprite = sprites.Get(id);
+            const auto size = glm::vec2(sprite.width, sprite.height) * transform.scale;
+            box = Aabb::Union(box, {low, high + size});
+        }
+        if (colliders.Has(id))
+        {
+            const auto &collider = colliders.Get(id);
+            const auto size = glm::vec2(collider.width, collider.height) * transform.scale;
+            box = Aabb::Union(box, {low + collider.offset, high + collider.offset + size});
+        }
+        return box;
+    }
+
+  public:
+    SpatialSystem() { RequireComponent<TransformComponent>(); }
+
+    // Adds the new entities to the tree, moves the ones that moved and removes the ones that are gone
+    void Update()
+    {
+        PROFILE_SCOPE("SpatialSystem::Update");
+        ALLOCATION_SCOPE(ALLOC_PHYSICS);
+
+        const auto &transforms = GetPool<TransformComponent>();
+        const auto &sprites = GetPool<SpriteComponent>();
+        const auto &colliders = GetPool<BoxColliderComponent>();
+
+        updateCount++;
+        reinsertions = 0;
+        for (auto entity : GetSystemEntities())
+        {
+            const auto id = entity.GetId();
+            if (static_cast<size_t>(id) >= proxies.size())
+            {
+                const auto size = std::max(static_cast<size_t>(id) + 1, proxies.size() * 2);
+                proxies.resize(size, AABB_TREE_NULL);
+                lastSeen.resize(size, 0);
+            }
+            lastSeen[id] = updateCount;
+
+            const auto box = ComputeBox(id, transforms, sprites, colliders);
+            if (proxies[id] == AABB_TREE_NULL)
+            {
+                proxies[id] = tree.CreateProxy(box, id);
+                trackedEntities.push_back(id);
+            }
+            else if (tree.MoveProxy(proxies[id], box))
+            {
+                reinsertions++;
+            }
+        }
+
+        // Entities that left the system since the last update
+        if (trackedEntities.size() != GetSystemEntities().size())
+        {
+            size_t kept = 0;
+            for (auto id : trackedEntities)
+            {
+                if (lastSeen[id] == updateCount)
+                {
+                    trackedEntities[kept++] = id;
+                    continue;
+                }
+                tree.DestroyProxy(proxies[id]);
+                proxies[id] = AABB_TREE_NULL;
+            }
+            trackedEntities.resize(kept);
+        }
+    }
+
+    const AabbTree &GetTree() const { return tree; }
+    size_t GetReinsertions() const { return reinsertions; }
+};